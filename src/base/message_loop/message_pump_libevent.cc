@@ -5,6 +5,7 @@
 #include "base/message_loop/message_pump_libevent.h"
 
 #include <errno.h>
+#include <stdint.h>
 #include <unistd.h>
 
 #include <memory>
@@ -25,6 +26,11 @@
 #include "base/mac/scoped_nsautorelease_pool.h"
 #endif
 
+#if defined(OS_LINUX) || defined(OS_CHROMEOS) || defined(OS_ANDROID)
+#include <sys/eventfd.h>
+#define USE_EVENTFD_WAKEUP
+#endif
+
 // Lifecycle of struct event
 // Libevent uses two main data structures:
 // struct event_base (of which there is one per message pump), and
@@ -109,7 +115,7 @@ MessagePumpLibevent::~MessagePumpLibevent() {
     if (IGNORE_EINTR(close(wakeup_pipe_in_)) < 0)
       DPLOG(ERROR) << "close";
   }
-  if (wakeup_pipe_out_ >= 0) {
+  if (wakeup_pipe_out_ >= 0 && wakeup_pipe_out_ != wakeup_pipe_in_) {
     if (IGNORE_EINTR(close(wakeup_pipe_out_)) < 0)
       DPLOG(ERROR) << "close";
   }
@@ -277,9 +283,16 @@ void MessagePumpLibevent::Quit() {
 
 void MessagePumpLibevent::ScheduleWork() {
   // Tell libevent (in a threadsafe way) that it should break out of its loop.
+#if defined(USE_EVENTFD_WAKEUP)
+  uint64_t value = 1;
+  int nwrite = HANDLE_EINTR(write(wakeup_pipe_in_, &value, sizeof(value)));
+  DPCHECK(nwrite == static_cast<int>(sizeof(value)) || errno == EAGAIN)
+      << "nwrite:" << nwrite;
+#else
   char buf = 0;
   int nwrite = HANDLE_EINTR(write(wakeup_pipe_in_, &buf, 1));
   DPCHECK(nwrite == 1 || errno == EAGAIN) << "nwrite:" << nwrite;
+#endif
 }
 
 void MessagePumpLibevent::ScheduleDelayedWork(
@@ -291,6 +304,17 @@ void MessagePumpLibevent::ScheduleDelayedWork(
 }
 
 bool MessagePumpLibevent::Init() {
+#if defined(USE_EVENTFD_WAKEUP)
+  // An eventfd counter coalesces any number of pending wakeups into a single
+  // read and costs one descriptor instead of two.
+  int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (fd < 0) {
+    DPLOG(ERROR) << "eventfd creation failed";
+    return false;
+  }
+  wakeup_pipe_out_ = fd;
+  wakeup_pipe_in_ = fd;
+#else
   int fds[2];
   if (!CreateLocalNonBlockingPipe(fds)) {
     DPLOG(ERROR) << "pipe creation failed";
@@ -298,6 +322,7 @@ bool MessagePumpLibevent::Init() {
   }
   wakeup_pipe_out_ = fds[0];
   wakeup_pipe_in_ = fds[1];
+#endif
 
   wakeup_event_ = new event;
   event_set(wakeup_event_, wakeup_pipe_out_, EV_READ | EV_PERSIST,
@@ -356,10 +381,17 @@ void MessagePumpLibevent::OnWakeup(int socket, short flags, void* context) {
   MessagePumpLibevent* that = static_cast<MessagePumpLibevent*>(context);
   DCHECK(that->wakeup_pipe_out_ == socket);
 
+#if defined(USE_EVENTFD_WAKEUP)
+  // Reset the counter, discarding all pending wakeups at once.
+  uint64_t value;
+  int nread = HANDLE_EINTR(read(socket, &value, sizeof(value)));
+  DCHECK_EQ(nread, static_cast<int>(sizeof(value)));
+#else
   // Remove and discard the wakeup byte.
   char buf;
   int nread = HANDLE_EINTR(read(socket, &buf, 1));
   DCHECK_EQ(nread, 1);
+#endif
   that->processed_io_events_ = true;
   // Tell libevent to break out of inner loop.
   event_base_loopbreak(that->event_base_);
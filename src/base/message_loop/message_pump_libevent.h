@@ -109,7 +109,8 @@ class BASE_EXPORT MessagePumpLibevent : public MessagePump,
   // readiness callbacks when a socket is ready for I/O.
   event_base* const event_base_;
 
-  // ... write end; ScheduleWork() writes a single byte to it
+  // ... write end; ScheduleWork() writes a single byte to it. On Linux and
+  // Android, both ends are the same eventfd.
   int wakeup_pipe_in_ = -1;
   // ... read end; OnWakeup reads it and then breaks Run() out of its sleep
   int wakeup_pipe_out_ = -1;
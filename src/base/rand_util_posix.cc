@@ -11,18 +11,13 @@
 #include <unistd.h>
 
 #include "base/check.h"
-#include "base/compiler_specific.h"
 #include "base/files/file_util.h"
 #include "base/no_destructor.h"
 #include "base/posix/eintr_wrapper.h"
 #include "build/build_config.h"
 
-#if (defined(OS_LINUX) || defined(OS_CHROMEOS)) && !defined(OS_NACL)
-#include "third_party/lss/linux_syscall_support.h"
-#elif defined(OS_MAC)
-// TODO(crbug.com/995996): Waiting for this header to appear in the iOS SDK.
-// (See below.)
-#include <sys/random.h>
+#if !defined(OS_NACL)
+#include "third_party/boringssl/src/include/openssl/rand.h"
 #endif
 
 namespace {
@@ -56,43 +51,19 @@ class URandomFd {
 
 namespace base {
 
-// NOTE: In an ideal future, all implementations of this function will just
-// wrap BoringSSL's `RAND_bytes`. TODO(crbug.com/995996): Figure out the
-// build/test/performance issues with dcheng's CL
-// (https://chromium-review.googlesource.com/c/chromium/src/+/1545096) and land
-// it or some form of it.
 void RandBytes(void* output, size_t output_length) {
-#if (defined(OS_LINUX) || defined(OS_CHROMEOS)) && !defined(OS_NACL)
-  // We have to call `getrandom` via Linux Syscall Support, rather than through
-  // the libc wrapper, because we might not have an up-to-date libc (e.g. on
-  // some bots).
-  const ssize_t r = HANDLE_EINTR(sys_getrandom(output, output_length, 0));
-
-  // Return success only on total success. In case errno == ENOSYS (or any other
-  // error), we'll fall through to reading from urandom below.
-  if (output_length == static_cast<size_t>(r)) {
-    MSAN_UNPOISON(output, output_length);
-    return;
-  }
-#elif defined(OS_MAC)
-  // TODO(crbug.com/995996): Enable this on iOS too, when sys/random.h arrives
-  // in its SDK.
-  if (__builtin_available(macOS 10.12, *)) {
-    if (getentropy(output, output_length) == 0) {
-      return;
-    }
-  }
-#endif
-
-  // If the OS-specific mechanisms didn't work, fall through to reading from
-  // urandom.
-  //
-  // TODO(crbug.com/995996): When we no longer need to support old Linux
-  // kernels, we can get rid of this /dev/urandom branch altogether.
+#if !defined(OS_NACL)
+  // BoringSSL keeps a CTR-DRBG per thread that is seeded from the OS, reseeded
+  // periodically and reset on fork. Unlike reading from the OS on every call,
+  // this keeps callers on hot paths, such as per-frame padding, out of the
+  // kernel.
+  RAND_bytes(static_cast<uint8_t*>(output), output_length);
+#else
   const int urandom_fd = GetUrandomFD();
   const bool success =
       ReadFromFD(urandom_fd, static_cast<char*>(output), output_length);
   CHECK(success);
+#endif
 }
 
 int GetUrandomFD() {
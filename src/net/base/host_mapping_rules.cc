@@ -4,6 +4,7 @@
 
 #include "net/base/host_mapping_rules.h"
 
+#include <algorithm>
 #include <string>
 
 #include "base/logging.h"
@@ -16,17 +17,87 @@
 
 namespace net {
 
+namespace {
+
+// Patterns without wildcards or escapes only match a host literally. They
+// cannot match "host:port" unless they contain a colon.
+bool IsLiteralPattern(base::StringPiece pattern) {
+  return pattern.find_first_of("*?\\:") == base::StringPiece::npos;
+}
+
+}  // namespace
+
 struct HostMappingRules::MapRule {
   MapRule() : replacement_port(-1) {}
 
-  std::string hostname_pattern;
   std::string replacement_hostname;
   int replacement_port;
 };
 
-struct HostMappingRules::ExclusionRule {
-  std::string hostname_pattern;
-};
+HostMappingRules::PatternIndex::PatternIndex() = default;
+
+HostMappingRules::PatternIndex::PatternIndex(
+    const PatternIndex& pattern_index) = default;
+
+HostMappingRules::PatternIndex::~PatternIndex() = default;
+
+HostMappingRules::PatternIndex& HostMappingRules::PatternIndex::operator=(
+    const PatternIndex& pattern_index) = default;
+
+void HostMappingRules::PatternIndex::Add(const std::string& pattern) {
+  size_t position = size_++;
+  // Earlier patterns take precedence, so existing entries are kept.
+  if (IsLiteralPattern(pattern)) {
+    exact_.emplace(pattern, position);
+  } else if (pattern.size() > 2 && pattern[0] == '*' && pattern[1] == '.' &&
+             IsLiteralPattern(base::StringPiece(pattern).substr(1))) {
+    suffixes_.emplace(pattern.substr(1), position);
+  } else {
+    others_.emplace_back(position, pattern);
+  }
+}
+
+void HostMappingRules::PatternIndex::Clear() {
+  size_ = 0;
+  exact_.clear();
+  suffixes_.clear();
+  others_.clear();
+}
+
+size_t HostMappingRules::PatternIndex::FindFirst(const HostPortPair& host_port,
+                                                 bool match_port) const {
+  const std::string& host = host_port.host();
+  size_t first = std::string::npos;
+
+  auto exact_it = exact_.find(host);
+  if (exact_it != exact_.end())
+    first = exact_it->second;
+
+  if (!suffixes_.empty()) {
+    // "*.foo.com" matches every host ending with ".foo.com".
+    for (size_t dot = host.find('.'); dot != std::string::npos;
+         dot = host.find('.', dot + 1)) {
+      auto suffix_it = suffixes_.find(host.substr(dot));
+      if (suffix_it != suffixes_.end())
+        first = std::min(first, suffix_it->second);
+    }
+  }
+
+  std::string host_port_string;
+  for (const auto& position_pattern : others_) {
+    if (position_pattern.first >= first)
+      break;
+    if (base::MatchPattern(host, position_pattern.second))
+      return position_pattern.first;
+    if (match_port) {
+      if (host_port_string.empty())
+        host_port_string = host_port.ToString();
+      if (base::MatchPattern(host_port_string, position_pattern.second))
+        return position_pattern.first;
+    }
+  }
+  return first;
+}
 
 HostMappingRules::HostMappingRules() = default;
 
@@ -39,34 +110,28 @@ HostMappingRules& HostMappingRules::operator=(
     const HostMappingRules& host_mapping_rules) = default;
 
 bool HostMappingRules::RewriteHost(HostPortPair* host_port) const {
-  // Check if the hostname was remapped.
-  for (const auto& rule : map_rules_) {
-    // The rule's hostname_pattern will be something like:
-    //     www.foo.com
-    //     *.foo.com
-    //     www.foo.com:1234
-    //     *.foo.com:1234
-    // First, we'll check for a match just on hostname.
-    // If that fails, we'll check for a match with both hostname and port.
-    if (!base::MatchPattern(host_port->host(), rule.hostname_pattern)) {
-      std::string host_port_string = host_port->ToString();
-      if (!base::MatchPattern(host_port_string, rule.hostname_pattern))
-        continue;  // This rule doesn't apply.
-    }
-
-    // Check if the hostname was excluded.
-    for (const auto& rule : exclusion_rules_) {
-      if (base::MatchPattern(host_port->host(), rule.hostname_pattern))
-        return false;
-    }
-
-    host_port->set_host(rule.replacement_hostname);
-    if (rule.replacement_port != -1)
-      host_port->set_port(static_cast<uint16_t>(rule.replacement_port));
-    return true;
+  // Check if the hostname was remapped. The map patterns will be something
+  // like:
+  //     www.foo.com
+  //     *.foo.com
+  //     www.foo.com:1234
+  //     *.foo.com:1234
+  // A pattern matches either just the hostname, or both hostname and port.
+  size_t position = map_patterns_.FindFirst(*host_port, /*match_port=*/true);
+  if (position == std::string::npos)
+    return false;  // No rule applies.
+
+  // Check if the hostname was excluded.
+  if (exclusion_patterns_.FindFirst(*host_port, /*match_port=*/false) !=
+      std::string::npos) {
+    return false;
   }
 
-  return false;
+  const MapRule& rule = map_rules_[position];
+  host_port->set_host(rule.replacement_hostname);
+  if (rule.replacement_port != -1)
+    host_port->set_port(static_cast<uint16_t>(rule.replacement_port));
+  return true;
 }
 
 bool HostMappingRules::AddRuleFromString(base::StringPiece rule_string) {
@@ -76,23 +141,20 @@ bool HostMappingRules::AddRuleFromString(base::StringPiece rule_string) {
 
   // Test for EXCLUSION rule.
   if (parts.size() == 2 && base::LowerCaseEqualsASCII(parts[0], "exclude")) {
-    ExclusionRule rule;
-    rule.hostname_pattern = base::ToLowerASCII(parts[1]);
-    exclusion_rules_.push_back(rule);
+    exclusion_patterns_.Add(base::ToLowerASCII(parts[1]));
     return true;
   }
 
   // Test for MAP rule.
   if (parts.size() == 3 && base::LowerCaseEqualsASCII(parts[0], "map")) {
     MapRule rule;
-    rule.hostname_pattern = base::ToLowerASCII(parts[1]);
-
     if (!ParseHostAndPort(parts[2], &rule.replacement_hostname,
                           &rule.replacement_port)) {
       return false;  // Failed parsing the hostname/port.
     }
 
     map_rules_.push_back(rule);
+    map_patterns_.Add(base::ToLowerASCII(parts[1]));
     return true;
   }
 
@@ -100,8 +162,9 @@ bool HostMappingRules::AddRuleFromString(base::StringPiece rule_string) {
 }
 
 void HostMappingRules::SetRulesFromString(base::StringPiece rules_string) {
-  exclusion_rules_.clear();
+  exclusion_patterns_.Clear();
   map_rules_.clear();
+  map_patterns_.Clear();
 
   std::vector<base::StringPiece> rules = base::SplitStringPiece(
       rules_string, ",", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL);
@@ -5,6 +5,10 @@
 #ifndef NET_BASE_HOST_MAPPING_RULES_H_
 #define NET_BASE_HOST_MAPPING_RULES_H_
 
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "base/macros.h"
@@ -42,13 +46,44 @@ class NET_EXPORT_PRIVATE HostMappingRules {
 
  private:
   struct MapRule;
-  struct ExclusionRule;
+
+  // Finds the first pattern matching a host without walking every pattern.
+  // Literal patterns and "*.suffix" patterns are looked up by hash, once per
+  // label of the host. Other patterns are matched in order.
+  class PatternIndex {
+   public:
+    PatternIndex();
+    PatternIndex(const PatternIndex& pattern_index);
+    ~PatternIndex();
+
+    PatternIndex& operator=(const PatternIndex& pattern_index);
+
+    // Adds |pattern| after the existing ones.
+    void Add(const std::string& pattern);
+
+    void Clear();
+
+    // Returns the position of the first pattern that matches the host of
+    // |host_port|, or with |match_port|, the whole |host_port|. Returns
+    // std::string::npos if none matches.
+    size_t FindFirst(const HostPortPair& host_port, bool match_port) const;
+
+   private:
+    size_t size_ = 0;
+    // Positions of the first literal patterns.
+    std::unordered_map<std::string, size_t> exact_;
+    // Positions of the first "*.suffix" patterns, keyed by ".suffix".
+    std::unordered_map<std::string, size_t> suffixes_;
+    // The remaining patterns with their positions, in order.
+    std::vector<std::pair<size_t, std::string>> others_;
+  };
 
   typedef std::vector<MapRule> MapRuleList;
-  typedef std::vector<ExclusionRule> ExclusionRuleList;
 
+  // In the same order as |map_patterns_|.
   MapRuleList map_rules_;
-  ExclusionRuleList exclusion_rules_;
+  PatternIndex map_patterns_;
+  PatternIndex exclusion_patterns_;
 };
 
 }  // namespace net
@@ -4,6 +4,7 @@
 
 #include <string>
 
+#include "base/hash/hash.h"
 #include "base/values.h"
 #include "net/base/network_isolation_key.h"
 #include "net/base/registry_controlled_domains/registry_controlled_domain.h"
@@ -117,6 +118,15 @@ std::string NetworkIsolationKey::ToDebugString() const {
   return return_string;
 }
 
+size_t NetworkIsolationKey::GetHash() const {
+  size_t hash = opaque_and_non_transient_;
+  if (top_frame_site_)
+    hash = base::HashInts(hash, top_frame_site_->GetHash());
+  if (frame_site_)
+    hash = base::HashInts(hash, frame_site_->GetHash());
+  return hash;
+}
+
 bool NetworkIsolationKey::IsFullyPopulated() const {
   return top_frame_site_.has_value() && frame_site_.has_value();
 }
@@ -5,6 +5,7 @@
 #ifndef NET_BASE_NETWORK_ISOLATION_KEY_H_
 #define NET_BASE_NETWORK_ISOLATION_KEY_H_
 
+#include <cstddef>
 #include <string>
 
 #include "base/gtest_prod_util.h"
@@ -119,6 +120,9 @@ class NET_EXPORT NetworkIsolationKey {
                     other.opaque_and_non_transient_);
   }
 
+  // Returns a hash consistent with operator==, for hashed containers.
+  size_t GetHash() const;
+
   // Returns the string representation of the key, which is the string
   // representation of each piece of the key separated by spaces.
   std::string ToString() const;
@@ -5,7 +5,9 @@
 #include "net/base/schemeful_site.h"
 
 #include "base/check.h"
+#include "base/hash/hash.h"
 #include "base/metrics/histogram_macros.h"
+#include "base/unguessable_token.h"
 #include "net/base/registry_controlled_domains/registry_controlled_domain.h"
 #include "net/base/url_util.h"
 #include "url/gurl.h"
@@ -163,6 +165,17 @@ bool SchemefulSite::operator<(const SchemefulSite& other) const {
   return site_as_origin_ < other.site_as_origin_;
 }
 
+size_t SchemefulSite::GetHash() const {
+  // Opaque sites are only equal to sites with the same nonce.
+  absl::optional<base::UnguessableToken> nonce =
+      site_as_origin_.GetNonceForSerialization();
+  if (nonce)
+    return base::UnguessableTokenHash()(*nonce);
+  return base::HashInts(base::FastHash(site_as_origin_.scheme()),
+                        base::HashInts(base::FastHash(site_as_origin_.host()),
+                                       site_as_origin_.port()));
+}
+
 // static
 absl::optional<SchemefulSite> SchemefulSite::DeserializeWithNonce(
     const std::string& value) {
@@ -5,6 +5,7 @@
 #ifndef NET_BASE_SCHEMEFUL_SITE_H_
 #define NET_BASE_SCHEMEFUL_SITE_H_
 
+#include <cstddef>
 #include <ostream>
 #include <string>
 
@@ -123,6 +124,10 @@ class NET_EXPORT SchemefulSite {
 
   bool operator<(const SchemefulSite& other) const;
 
+  // Returns a hash consistent with operator==. Initializes the nonce of an
+  // opaque site.
+  size_t GetHash() const;
+
  private:
   // IPC serialization code needs to access internal origin.
   friend struct mojo::StructTraits<network::mojom::SchemefulSiteDataView,
@@ -17,6 +17,8 @@
 
 #include <array>
 #include <memory>
+#include <set>
+#include <string>
 #include <vector>
 
 #include "base/environment.h"
@@ -50,6 +52,8 @@
 #include "third_party/boringssl/src/include/openssl/pool.h"
 #else
 #include "base/lazy_instance.h"
+#include "crypto/sha2.h"
+#include "net/cert/pem.h"
 #endif
 
 namespace net {
@@ -317,7 +321,7 @@ class StaticUnixSystemCerts {
     bool cert_file_ok = false;
     for (const auto& filename : cert_filenames) {
       std::string file;
-      if (!base::ReadFileToString(base::FilePath(filename), &file))
+      if (!ReadFileOnce(base::FilePath(filename), &file))
         continue;
       if (AddCertificatesFromBytes(file.data(), file.size())) {
         cert_file_ok = true;
@@ -338,7 +342,7 @@ class StaticUnixSystemCerts {
                              /*recursive=*/true, base::FileEnumerator::FILES);
       for (auto filename = e.Next(); !filename.empty(); filename = e.Next()) {
         std::string file;
-        if (!base::ReadFileToString(filename, &file)) {
+        if (!ReadFileOnce(filename, &file)) {
           continue;
         }
         if (AddCertificatesFromBytes(file.data(), file.size())) {
@@ -358,14 +362,42 @@ class StaticUnixSystemCerts {
   TrustStoreInMemory* system_trust_store() { return &system_trust_store_; }
 
  private:
+  // The certificate directories usually contain the certificate file itself
+  // and several symlinks to each certificate. Returns false for files that
+  // have been read already through another path.
+  bool ReadFileOnce(const base::FilePath& path, std::string* file) {
+    base::FilePath real_path = base::MakeAbsoluteFilePath(path);
+    if (real_path.empty() || !read_files_.insert(real_path).second)
+      return false;
+    return base::ReadFileToString(real_path, file);
+  }
+
   bool AddCertificatesFromBytes(const char* data, size_t length) {
-    auto certs = X509Certificate::CreateCertificateListFromBytes(
-        data, length, X509Certificate::FORMAT_AUTO);
+    std::vector<std::string> certs;
+    PEMTokenizer pem_tokenizer(base::StringPiece(data, length),
+                               {"CERTIFICATE"});
+    while (pem_tokenizer.GetNext())
+      certs.push_back(pem_tokenizer.data());
+    if (certs.empty()) {
+      // Not PEM certificates, maybe DER or PKCS #7.
+      for (const auto& cert : X509Certificate::CreateCertificateListFromBytes(
+               data, length, X509Certificate::FORMAT_AUTO)) {
+        certs.push_back(std::string(
+            x509_util::CryptoBufferAsStringPiece(cert->cert_buffer())));
+      }
+    }
+
     bool certs_ok = false;
     for (const auto& cert : certs) {
+      // The certificate bundle and the per-certificate files contain the same
+      // certificates. Duplicates are skipped before the expensive parsing.
+      if (!seen_certs_.insert(crypto::SHA256HashString(cert)).second) {
+        certs_ok = true;
+        continue;
+      }
       CertErrors errors;
       auto parsed = ParsedCertificate::Create(
-          bssl::UpRef(cert->cert_buffer()),
+          x509_util::CreateCryptoBuffer(cert),
           x509_util::DefaultParseCertificateOptions(), &errors);
       if (parsed) {
         if (!system_trust_store_.Contains(parsed.get())) {
@@ -380,6 +412,9 @@ class StaticUnixSystemCerts {
   }
 
   TrustStoreInMemory system_trust_store_;
+  std::set<base::FilePath> read_files_;
+  // SHA-256 hashes of the certificates read.
+  std::set<std::string> seen_certs_;
 };
 
 base::LazyInstance<StaticUnixSystemCerts>::Leaky g_root_certs_static_unix =
@@ -257,7 +257,8 @@ class DnsClientImpl : public DnsClient {
       DCHECK(new_effective_config.value().IsValid());
 
       auto socket_allocator = std::make_unique<DnsSocketAllocator>(
-          socket_factory_, new_effective_config.value().nameservers, net_log_);
+          socket_factory_, new_effective_config.value().nameservers,
+          new_effective_config.value().reuse_sockets, net_log_);
       session_ = new DnsSession(std::move(new_effective_config).value(),
                                 std::move(socket_allocator), rand_int_callback_,
                                 net_log_);
@@ -30,6 +30,7 @@ DnsConfig::DnsConfig(std::vector<IPEndPoint> nameservers)
       doh_attempts(1),
       rotate(false),
       use_local_ipv6(false),
+      reuse_sockets(false),
       secure_dns_mode(SecureDnsMode::kOff),
       allow_dns_over_https_upgrade(false) {}
 
@@ -60,6 +61,7 @@ bool DnsConfig::EqualsIgnoreHosts(const DnsConfig& d) const {
          (ndots == d.ndots) && (fallback_period == d.fallback_period) &&
          (attempts == d.attempts) && (doh_attempts == d.doh_attempts) &&
          (rotate == d.rotate) && (use_local_ipv6 == d.use_local_ipv6) &&
+         (reuse_sockets == d.reuse_sockets) &&
          (dns_over_https_servers == d.dns_over_https_servers) &&
          (secure_dns_mode == d.secure_dns_mode) &&
          (allow_dns_over_https_upgrade == d.allow_dns_over_https_upgrade) &&
@@ -79,6 +81,7 @@ void DnsConfig::CopyIgnoreHosts(const DnsConfig& d) {
   doh_attempts = d.doh_attempts;
   rotate = d.rotate;
   use_local_ipv6 = d.use_local_ipv6;
+  reuse_sockets = d.reuse_sockets;
   dns_over_https_servers = d.dns_over_https_servers;
   secure_dns_mode = d.secure_dns_mode;
   allow_dns_over_https_upgrade = d.allow_dns_over_https_upgrade;
@@ -108,6 +111,7 @@ base::Value DnsConfig::ToValue() const {
   dict.SetIntKey("doh_attempts", doh_attempts);
   dict.SetBoolKey("rotate", rotate);
   dict.SetBoolKey("use_local_ipv6", use_local_ipv6);
+  dict.SetBoolKey("reuse_sockets", reuse_sockets);
   dict.SetIntKey("num_hosts", hosts.size());
   list = base::Value(base::Value::Type::LIST);
   for (auto& server : dns_over_https_servers) {
@@ -95,6 +95,10 @@ struct NET_EXPORT DnsConfig {
   // as it may cause them to return incorrect results.
   bool use_local_ipv6;
 
+  // Keeps UDP sockets and TCP connections to the nameservers for reuse by
+  // later queries. See DnsSocketAllocator.
+  bool reuse_sockets;
+
   // List of servers to query over HTTPS, queried in order
   // (https://tools.ietf.org/id/draft-ietf-doh-dns-over-https-12.txt).
   std::vector<DnsOverHttpsServerConfig> dns_over_https_servers;
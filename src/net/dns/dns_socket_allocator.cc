@@ -4,6 +4,8 @@
 
 #include "net/dns/dns_socket_allocator.h"
 
+#include <utility>
+
 #include "base/logging.h"
 #include "base/rand_util.h"
 #include "build/build_config.h"
@@ -17,13 +19,32 @@
 
 namespace net {
 
+namespace {
+
+const size_t kMaxPooledUdpSockets = 16;
+// A pooled UDP socket is closed instead of being returned to the pool with
+// probability 1/kUdpSocketRetireRange, so that the local ports in use keep
+// changing.
+const uint64_t kUdpSocketRetireRange = 64;
+const size_t kMaxIdleTcpSockets = 4;
+// Shorter than the idle timeouts recommended for servers by RFC 7766.
+constexpr base::TimeDelta kTcpIdleTimeout = base::TimeDelta::FromSeconds(10);
+
+}  // namespace
+
 DnsSocketAllocator::DnsSocketAllocator(ClientSocketFactory* socket_factory,
                                        std::vector<IPEndPoint> nameservers,
+                                       bool reuse_sockets,
                                        NetLog* net_log)
     : socket_factory_(socket_factory),
       net_log_(net_log),
-      nameservers_(std::move(nameservers)) {
+      nameservers_(std::move(nameservers)),
+      reuse_sockets_(reuse_sockets) {
   DCHECK(socket_factory_);
+  if (reuse_sockets_) {
+    udp_sockets_.resize(nameservers_.size());
+    tcp_sockets_.resize(nameservers_.size());
+  }
 }
 
 DnsSocketAllocator::~DnsSocketAllocator() = default;
@@ -36,6 +57,16 @@ DnsSocketAllocator::CreateConnectedUdpSocket(size_t server_index,
 
   std::unique_ptr<DatagramClientSocket> socket;
 
+  if (reuse_sockets_ && !udp_sockets_[server_index].empty()) {
+    auto& pool = udp_sockets_[server_index];
+    size_t index = base::RandGenerator(pool.size());
+    std::swap(pool[index], pool.back());
+    socket = std::move(pool.back());
+    pool.pop_back();
+    *out_connection_error = OK;
+    return socket;
+  }
+
   NetLogSource no_source;
   socket = socket_factory_->CreateDatagramClientSocket(
       DatagramSocket::RANDOM_BIND, net_log_, no_source);
@@ -50,11 +81,39 @@ DnsSocketAllocator::CreateConnectedUdpSocket(size_t server_index,
   return socket;
 }
 
+void DnsSocketAllocator::FreeUdpSocket(
+    size_t server_index,
+    std::unique_ptr<DatagramClientSocket> socket) {
+  DCHECK_LT(server_index, nameservers_.size());
+  DCHECK(socket);
+
+  if (!reuse_sockets_)
+    return;
+  auto& pool = udp_sockets_[server_index];
+  if (pool.size() >= kMaxPooledUdpSockets ||
+      base::RandGenerator(kUdpSocketRetireRange) == 0) {
+    return;
+  }
+  pool.push_back(std::move(socket));
+}
+
 std::unique_ptr<StreamSocket> DnsSocketAllocator::CreateTcpSocket(
     size_t server_index,
     const NetLogSource& source) {
   DCHECK_LT(server_index, nameservers_.size());
 
+  if (reuse_sockets_) {
+    auto& pool = tcp_sockets_[server_index];
+    base::TimeTicks now = base::TimeTicks::Now();
+    while (!pool.empty()) {
+      std::unique_ptr<StreamSocket> socket = std::move(pool.back().first);
+      base::TimeTicks idle_since = pool.back().second;
+      pool.pop_back();
+      if (now - idle_since < kTcpIdleTimeout && socket->IsConnectedAndIdle())
+        return socket;
+    }
+  }
+
   // TODO(https://crbug.com/1123197): Pass a non-null NetworkQualityEstimator.
   NetworkQualityEstimator* network_quality_estimator = nullptr;
 
@@ -63,4 +122,17 @@ std::unique_ptr<StreamSocket> DnsSocketAllocator::CreateTcpSocket(
       network_quality_estimator, net_log_, source);
 }
 
+void DnsSocketAllocator::FreeTcpSocket(size_t server_index,
+                                       std::unique_ptr<StreamSocket> socket) {
+  DCHECK_LT(server_index, nameservers_.size());
+  DCHECK(socket);
+
+  if (!reuse_sockets_ || !socket->IsConnectedAndIdle())
+    return;
+  auto& pool = tcp_sockets_[server_index];
+  if (pool.size() >= kMaxIdleTcpSockets)
+    pool.erase(pool.begin());
+  pool.emplace_back(std::move(socket), base::TimeTicks::Now());
+}
+
 }  // namespace net
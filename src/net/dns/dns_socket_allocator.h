@@ -6,8 +6,10 @@
 #define NET_DNS_DNS_SOCKET_ALLOCATOR_H_
 
 #include <memory>
+#include <utility>
 #include <vector>
 
+#include "base/time/time.h"
 #include "net/base/net_export.h"
 #include "net/base/rand_callback.h"
 
@@ -21,32 +23,60 @@ struct NetLogSource;
 class StreamSocket;
 
 // Allocation logic for DNS UDP and TCP sockets.
+//
+// If |reuse_sockets| is set, sockets handed back after a completed query are
+// kept for later queries to the same nameserver: a bounded pool of connected
+// UDP sockets, picked at random to spread queries over their ports, and a few
+// idle TCP connections.
 class NET_EXPORT_PRIVATE DnsSocketAllocator {
  public:
   DnsSocketAllocator(ClientSocketFactory* factory,
                      std::vector<IPEndPoint> nameservers,
+                     bool reuse_sockets,
                      NetLog* net_log);
   ~DnsSocketAllocator();
 
   DnsSocketAllocator(const DnsSocketAllocator&) = delete;
   DnsSocketAllocator& operator=(const DnsSocketAllocator&) = delete;
 
+  bool reuse_sockets() const { return reuse_sockets_; }
+
   // Creates a UDP client socket that is already connected to the nameserver
   // referenced by |server_index| and sets |out_connection_error| to the result
-  // of the connection. On error connecting the socket, returns null.
+  // of the connection. On error connecting the socket, returns null. Returns a
+  // pooled socket instead if there is one.
   std::unique_ptr<DatagramClientSocket> CreateConnectedUdpSocket(
       size_t server_index,
       int* out_connection_error);
 
+  // Takes back a socket from CreateConnectedUdpSocket() whose query has been
+  // answered, so that no late responses are expected on it.
+  void FreeUdpSocket(size_t server_index,
+                     std::unique_ptr<DatagramClientSocket> socket);
+
   // Creates a StreamSocket for TCP to the nameserver referenced by
-  // |server_index|. Does not connect the seocket.
+  // |server_index|. Does not connect the seocket, unless it is an idle
+  // connection being reused.
   std::unique_ptr<StreamSocket> CreateTcpSocket(size_t server_index,
                                                 const NetLogSource& source);
 
+  // Takes back a socket from CreateTcpSocket() after a complete response has
+  // been read from it.
+  void FreeTcpSocket(size_t server_index, std::unique_ptr<StreamSocket> socket);
+
  private:
   ClientSocketFactory* const socket_factory_;
   NetLog* const net_log_;
   const std::vector<IPEndPoint> nameservers_;
+  const bool reuse_sockets_;
+
+  // Indexed by nameserver.
+  std::vector<std::vector<std::unique_ptr<DatagramClientSocket>>>
+      udp_sockets_;
+  // Idle connections and the time they became idle, most recent last.
+  std::vector<
+      std::vector<std::pair<std::unique_ptr<StreamSocket>, base::TimeTicks>>>
+      tcp_sockets_;
 };
 
 }  // namespace net
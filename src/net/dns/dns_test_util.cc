@@ -734,7 +734,7 @@ scoped_refptr<DnsSession> MockDnsClient::BuildSession() {
 
   auto socket_allocator = std::make_unique<DnsSocketAllocator>(
       &socket_factory_, effective_config_.value().nameservers,
-      nullptr /* net_log */);
+      effective_config_.value().reuse_sockets, nullptr /* net_log */);
 
   return base::MakeRefCounted<DnsSession>(
       effective_config_.value(), std::move(socket_allocator),
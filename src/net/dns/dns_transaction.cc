@@ -185,12 +185,20 @@ class DnsUDPAttempt : public DnsAttempt {
   DnsUDPAttempt(size_t server_index,
                 std::unique_ptr<DatagramClientSocket> socket,
                 std::unique_ptr<DnsQuery> query,
-                DnsUdpTracker* udp_tracker)
+                DnsUdpTracker* udp_tracker,
+                DnsSocketAllocator* socket_allocator)
       : DnsAttempt(server_index),
         next_state_(STATE_NONE),
         socket_(std::move(socket)),
         query_(std::move(query)),
-        udp_tracker_(udp_tracker) {}
+        udp_tracker_(udp_tracker),
+        socket_allocator_(socket_allocator) {}
+
+  ~DnsUDPAttempt() override {
+    // No more responses are expected on the socket once one has matched.
+    if (socket_ && !IsPending() && GetResponse())
+      socket_allocator_->FreeUdpSocket(server_index(), std::move(socket_));
+  }
 
   // DnsAttempt methods.
 
@@ -200,9 +208,13 @@ class DnsUDPAttempt : public DnsAttempt {
     start_time_ = base::TimeTicks::Now();
     next_state_ = STATE_SEND_QUERY;
 
+    // Reused sockets would be counted as port reuse, which the tracker takes
+    // as a sign of low entropy.
     IPEndPoint local_address;
-    if (socket_->GetLocalAddress(&local_address) == OK)
+    if (!socket_allocator_->reuse_sockets() &&
+        socket_->GetLocalAddress(&local_address) == OK) {
       udp_tracker_->RecordQuery(local_address.port(), query_->id());
+    }
 
     return DoLoop(OK);
   }
@@ -299,6 +311,15 @@ class DnsUDPAttempt : public DnsAttempt {
     if (response_->id())
       udp_tracker_->RecordResponseId(query_->id(), response_->id().value());
 
+    // A reused socket may still receive late or duplicate responses to its
+    // previous queries. The connected socket only accepts datagrams from the
+    // nameserver, so these are skipped by ID.
+    if (!parse_result && socket_allocator_->reuse_sockets() &&
+        response_->id() && response_->id().value() != query_->id()) {
+      next_state_ = STATE_READ_RESPONSE;
+      return OK;
+    }
+
     if (!parse_result)
       return ERR_DNS_MALFORMED_RESPONSE;
     if (response_->flags() & dns_protocol::kFlagTC)
@@ -326,6 +347,7 @@ class DnsUDPAttempt : public DnsAttempt {
   // Should be owned by the DnsSession, to which the transaction should own a
   // reference.
   DnsUdpTracker* const udp_tracker_;
+  DnsSocketAllocator* const socket_allocator_;
 
   std::unique_ptr<DnsResponse> response_;
 
@@ -600,14 +622,23 @@ class DnsTCPAttempt : public DnsAttempt {
  public:
   DnsTCPAttempt(size_t server_index,
                 std::unique_ptr<StreamSocket> socket,
-                std::unique_ptr<DnsQuery> query)
+                std::unique_ptr<DnsQuery> query,
+                DnsSocketAllocator* socket_allocator)
       : DnsAttempt(server_index),
         next_state_(STATE_NONE),
         socket_(std::move(socket)),
         query_(std::move(query)),
         length_buffer_(
             base::MakeRefCounted<IOBufferWithSize>(sizeof(uint16_t))),
-        response_length_(0) {}
+        response_length_(0),
+        socket_allocator_(socket_allocator) {}
+
+  ~DnsTCPAttempt() override {
+    // The whole response has been read, so the next query can be sent on the
+    // same connection.
+    if (socket_ && !IsPending() && GetResponse())
+      socket_allocator_->FreeTcpSocket(server_index(), std::move(socket_));
+  }
 
   // DnsAttempt:
   int Start(CompletionOnceCallback callback) override {
@@ -615,6 +646,9 @@ class DnsTCPAttempt : public DnsAttempt {
     callback_ = std::move(callback);
     start_time_ = base::TimeTicks::Now();
     next_state_ = STATE_CONNECT_COMPLETE;
+    // Idle connections handed out by the socket allocator are connected.
+    if (socket_->IsConnected())
+      return DoLoop(OK);
     int rv = socket_->Connect(
         base::BindOnce(&DnsTCPAttempt::OnIOComplete, base::Unretained(this)));
     if (rv == ERR_IO_PENDING) {
@@ -829,6 +863,9 @@ class DnsTCPAttempt : public DnsAttempt {
   uint16_t response_length_;
   std::unique_ptr<DnsResponse> response_;
 
+  // Owned by the DnsSession, to which the transaction owns a reference.
+  DnsSocketAllocator* const socket_allocator_;
+
   CompletionOnceCallback callback_;
 
   DISALLOW_COPY_AND_ASSIGN(DnsTCPAttempt);
@@ -1280,7 +1317,8 @@ class DnsTransactionImpl : public DnsTransaction,
 
     DnsUDPAttempt* attempt =
         new DnsUDPAttempt(server_index, std::move(socket), std::move(query),
-                          session_->udp_tracker());
+                          session_->udp_tracker(),
+                          session_->socket_allocator());
 
     attempts_.push_back(base::WrapUnique(attempt));
     ++attempts_count_;
@@ -1364,7 +1402,8 @@ class DnsTransactionImpl : public DnsTransaction,
     unsigned attempt_number = attempts_.size();
 
     DnsTCPAttempt* attempt =
-        new DnsTCPAttempt(server_index, std::move(socket), std::move(query));
+        new DnsTCPAttempt(server_index, std::move(socket), std::move(query),
+                          session_->socket_allocator());
 
     attempts_.push_back(base::WrapUnique(attempt));
     ++attempts_count_;
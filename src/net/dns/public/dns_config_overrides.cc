@@ -29,6 +29,7 @@ bool DnsConfigOverrides::operator==(const DnsConfigOverrides& other) const {
          ndots == other.ndots && fallback_period == other.fallback_period &&
          attempts == other.attempts && doh_attempts == other.doh_attempts &&
          rotate == other.rotate && use_local_ipv6 == other.use_local_ipv6 &&
+         reuse_sockets == other.reuse_sockets &&
          dns_over_https_servers == other.dns_over_https_servers &&
          secure_dns_mode == other.secure_dns_mode &&
          allow_dns_over_https_upgrade == other.allow_dns_over_https_upgrade &&
@@ -55,6 +56,7 @@ DnsConfigOverrides::CreateOverridingEverythingWithDefaults() {
   overrides.doh_attempts = defaults.doh_attempts;
   overrides.rotate = defaults.rotate;
   overrides.use_local_ipv6 = defaults.use_local_ipv6;
+  overrides.reuse_sockets = defaults.reuse_sockets;
   overrides.dns_over_https_servers = defaults.dns_over_https_servers;
   overrides.secure_dns_mode = defaults.secure_dns_mode;
   overrides.allow_dns_over_https_upgrade =
@@ -68,9 +70,9 @@ DnsConfigOverrides::CreateOverridingEverythingWithDefaults() {
 bool DnsConfigOverrides::OverridesEverything() const {
   return nameservers && search && append_to_multi_label_name && ndots &&
          fallback_period && attempts && doh_attempts && rotate &&
-         use_local_ipv6 && dns_over_https_servers && secure_dns_mode &&
-         allow_dns_over_https_upgrade && disabled_upgrade_providers &&
-         clear_hosts;
+         use_local_ipv6 && reuse_sockets && dns_over_https_servers &&
+         secure_dns_mode && allow_dns_over_https_upgrade &&
+         disabled_upgrade_providers && clear_hosts;
 }
 
 DnsConfig DnsConfigOverrides::ApplyOverrides(const DnsConfig& config) const {
@@ -97,6 +99,8 @@ DnsConfig DnsConfigOverrides::ApplyOverrides(const DnsConfig& config) const {
     overridden.rotate = rotate.value();
   if (use_local_ipv6)
     overridden.use_local_ipv6 = use_local_ipv6.value();
+  if (reuse_sockets)
+    overridden.reuse_sockets = reuse_sockets.value();
   if (dns_over_https_servers)
     overridden.dns_over_https_servers = dns_over_https_servers.value();
   if (secure_dns_mode)
@@ -56,6 +56,7 @@ struct NET_EXPORT DnsConfigOverrides {
   absl::optional<int> doh_attempts;
   absl::optional<bool> rotate;
   absl::optional<bool> use_local_ipv6;
+  absl::optional<bool> reuse_sockets;
   absl::optional<std::vector<DnsOverHttpsServerConfig>> dns_over_https_servers;
   absl::optional<SecureDnsMode> secure_dns_mode;
   absl::optional<bool> allow_dns_over_https_upgrade;
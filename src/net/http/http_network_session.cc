@@ -88,7 +88,9 @@ HttpNetworkSession::Params::Params()
       enable_spdy_ping_based_connection_checking(true),
       enable_http2(true),
       spdy_session_max_recv_window_size(kSpdySessionMaxRecvWindowSize),
+      spdy_session_recv_window_per_stream(0),
       spdy_session_max_queued_capped_frames(kSpdySessionMaxQueuedCappedFrames),
+      spdy_go_away_on_stream_cap(false),
       http2_end_stream_with_data_frame(false),
       time_func(&base::TimeTicks::Now),
       enable_http2_alternative_service(false),
@@ -178,10 +180,14 @@ HttpNetworkSession::HttpNetworkSession(const Params& params,
                          context.transport_security_state,
                          context.quic_context->params()->supported_versions,
                          params.enable_spdy_ping_based_connection_checking,
+                         params.spdy_health_check_interval,
+                         params.spdy_ping_timeout,
                          params.enable_http2,
                          params.enable_quic,
                          params.spdy_session_max_recv_window_size,
+                         params.spdy_session_recv_window_per_stream,
                          params.spdy_session_max_queued_capped_frames,
+                         params.spdy_go_away_on_stream_cap,
                          AddDefaultHttp2Settings(params.http2_settings),
                          params.greased_http2_frame,
                          params.http2_end_stream_with_data_frame,
@@ -102,10 +102,27 @@ class NET_EXPORT HttpNetworkSession {
 
     // Use SPDY ping frames to test for connection health after idle.
     bool enable_spdy_ping_based_connection_checking;
+    // If nonzero, SPDY sessions with active streams also send a ping whenever
+    // nothing has been read for this long, so that dead connections are
+    // detected without waiting for a new stream. The ping timeout is then
+    // derived from the smoothed ping RTT.
+    base::TimeDelta spdy_health_check_interval;
+    // If nonzero, overrides the maximum time to wait for a ping response
+    // before a SPDY session is considered dead.
+    base::TimeDelta spdy_ping_timeout;
     bool enable_http2;
     size_t spdy_session_max_recv_window_size;
+    // If nonzero, the session receive window of SPDY sessions grows to at
+    // least this much per active stream, so that sessions with many streams
+    // are not stalled by the shared session window.
+    size_t spdy_session_recv_window_per_stream;
     // Maximum number of capped frames that can be queued at any time.
     int spdy_session_max_queued_capped_frames;
+    // If true, SPDY sessions stop taking new streams once they reach the
+    // server's stream limit, so that further stream requests open a new
+    // session instead of queueing. Full sessions close after their last
+    // stream.
+    bool spdy_go_away_on_stream_cap;
     // HTTP/2 connection settings.
     // Unknown settings will still be sent to the server.
     // Might contain unknown setting identifiers from a predefined set that
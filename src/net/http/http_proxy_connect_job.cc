@@ -612,7 +612,7 @@ int HttpProxyConnectJob::DoSpdyProxyCreateStream() {
   return spdy_stream_request_->StartRequest(
       SPDY_BIDIRECTIONAL_STREAM, spdy_session,
       GURL("https://" + params_->endpoint().ToString()),
-      false /* no early data */, kH2QuicTunnelPriority, socket_tag(),
+      false /* no early data */, priority(), socket_tag(),
       spdy_session->net_log(),
       base::BindOnce(&HttpProxyConnectJob::OnIOComplete,
                      base::Unretained(this)),
@@ -703,15 +703,18 @@ int HttpProxyConnectJob::DoQuicProxyCreateStreamComplete(int result) {
       quic_session_->ReleaseStream();
 
   spdy::SpdyPriority spdy_priority =
-      ConvertRequestPriorityToQuicPriority(kH2QuicTunnelPriority);
+      ConvertRequestPriorityToQuicPriority(priority());
   spdy::SpdyStreamPrecedence precedence(spdy_priority);
   quic_stream->SetPriority(precedence);
 
+  QuicStreamFactory* quic_stream_factory =
+      common_connect_job_params()->quic_stream_factory;
   transport_socket_ = std::make_unique<QuicProxyClientSocket>(
       std::move(quic_stream), std::move(quic_session_),
       ProxyServer(GetProxyServerScheme(), GetDestination()), GetUserAgent(),
       params_->endpoint(), net_log(), http_auth_controller_.get(),
-      common_connect_job_params()->proxy_delegate);
+      common_connect_job_params()->proxy_delegate,
+      quic_stream_factory->zero_copy_proxy_writes());
   return transport_socket_->Connect(base::BindOnce(
       &HttpProxyConnectJob::OnIOComplete, base::Unretained(this)));
 }
@@ -773,8 +776,8 @@ int HttpProxyConnectJob::DoRestartWithAuthComplete(int result) {
 
 void HttpProxyConnectJob::ChangePriorityInternal(RequestPriority priority) {
   // Do not set the priority on |spdy_stream_request_| or
-  // |quic_stream_request_|, since those should always use
-  // kH2QuicTunnelPriority.
+  // |quic_stream_request_|. Established tunnel streams keep the priority they
+  // were created with.
   if (nested_connect_job_)
     nested_connect_job_->ChangePriority(priority);
 
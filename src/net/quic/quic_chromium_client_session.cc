@@ -2666,6 +2666,16 @@ void QuicChromiumClientSession::OnNetworkMadeDefault(
   StartMigrateBackToDefaultNetworkTimer(base::TimeDelta());
 }
 
+void QuicChromiumClientSession::OnIPAddressChanged() {
+  if (!allow_port_migration_ || migrate_session_early_v2_)
+    return;
+
+  // The old local address may no longer be usable, so this is handled like
+  // path degrading: a new path is validated before the session switches to it.
+  current_migration_cause_ = CHANGE_PORT_ON_PATH_DEGRADING;
+  MaybeMigrateToDifferentPortOnPathDegrading();
+}
+
 void QuicChromiumClientSession::MigrateNetworkImmediately(
     NetworkChangeNotifier::NetworkHandle network) {
   // There is no choice but to migrate to |network|. If any error encoutered,
@@ -810,6 +810,11 @@ class NET_EXPORT_PRIVATE QuicChromiumClientSession
   // network. Migrates this session to |new_network| if appropriate.
   void OnNetworkMadeDefault(NetworkChangeNotifier::NetworkHandle new_network);
 
+  // Called when NetworkChangeNotifier notifies observers of a local IP address
+  // change. Probes a different port on the default network and migrates this
+  // session to it if the probe succeeds.
+  void OnIPAddressChanged();
+
   // Schedules a migration alarm to wait for a new network.
   void OnNoNewNetwork();
 
@@ -24,6 +24,7 @@
 #include "net/third_party/quiche/src/quic/core/http/spdy_utils.h"
 #include "net/third_party/quiche/src/quic/core/quic_utils.h"
 #include "net/third_party/quiche/src/quic/core/quic_write_blocked_list.h"
+#include "net/third_party/quiche/src/quic/platform/api/quic_mem_slice_span.h"
 
 namespace net {
 namespace {
@@ -41,6 +42,19 @@ class ScopedBoolSaver {
   bool* var_;
   bool old_val_;
 };
+
+// Keeps the data pointer of |buffer| at the time of construction, so that
+// later changes to a DrainableIOBuffer do not affect data already queued.
+class RetainedIOBuffer : public WrappedIOBuffer {
+ public:
+  explicit RetainedIOBuffer(scoped_refptr<IOBuffer> buffer)
+      : WrappedIOBuffer(buffer->data()), buffer_(std::move(buffer)) {}
+
+ private:
+  ~RetainedIOBuffer() override = default;
+
+  scoped_refptr<IOBuffer> buffer_;
+};
 }  // namespace
 
 QuicChromiumClientStream::Handle::Handle(QuicChromiumClientStream* stream)
@@ -271,6 +285,22 @@ int QuicChromiumClientStream::Handle::WritevStreamData(
   return ERR_IO_PENDING;
 }
 
+int QuicChromiumClientStream::Handle::WriteStreamBuffer(
+    IOBuffer* buf,
+    int buf_len,
+    bool fin,
+    CompletionOnceCallback callback) {
+  ScopedBoolSaver saver(&may_invoke_callbacks_, false);
+  if (!stream_)
+    return net_error_;
+
+  if (stream_->WriteStreamBuffer(buf, buf_len, fin))
+    return HandleIOComplete(OK);
+
+  SetCallback(std::move(callback), &write_callback_);
+  return ERR_IO_PENDING;
+}
+
 int QuicChromiumClientStream::Handle::Read(IOBuffer* buf, int buf_len) {
   if (!stream_)
     return net_error_;
@@ -657,6 +687,26 @@ bool QuicChromiumClientStream::WritevStreamData(
   return !HasBufferedData();  // Was all data written?
 }
 
+bool QuicChromiumClientStream::WriteStreamBuffer(IOBuffer* buf,
+                                                 int buf_len,
+                                                 bool fin) {
+  DCHECK(!HasBufferedData() || VersionUsesHttp3(quic_version_));
+  DCHECK_GT(buf_len, 0);
+  // WriteBodySlices() only takes the data when the send buffer is below its
+  // threshold. Otherwise copies and buffers the data as WriteStreamData().
+  if (!CanWriteNewData())
+    return WriteStreamData(absl::string_view(buf->data(), buf_len), fin);
+
+  quic::QuicMemSlice slice(quic::QuicMemSliceImpl(
+      base::MakeRefCounted<RetainedIOBuffer>(buf), buf_len));
+  quic::QuicConsumedData consumed =
+      WriteBodySlices(quic::QuicMemSliceSpan(&slice), fin);
+  if (consumed.bytes_consumed == 0)
+    return WriteStreamData(absl::string_view(buf->data(), buf_len), fin);
+  DCHECK_EQ(static_cast<size_t>(buf_len), consumed.bytes_consumed);
+  return !HasBufferedData();  // Was all data written?
+}
+
 std::unique_ptr<QuicChromiumClientStream::Handle>
 QuicChromiumClientStream::CreateHandle() {
   DCHECK(!handle_);
@@ -99,6 +99,15 @@ class NET_EXPORT_PRIVATE QuicChromiumClientStream
                          bool fin,
                          CompletionOnceCallback callback);
 
+    // Same as WriteStreamData except it sends the first |buf_len| bytes of
+    // |buf| without copying them into the stream send buffer. |buf| is
+    // retained until the data is acked, so its contents must not be modified
+    // after this call.
+    int WriteStreamBuffer(IOBuffer* buf,
+                          int buf_len,
+                          bool fin,
+                          CompletionOnceCallback callback);
+
     // Reads at most |buf_len| bytes into |buf|. Returns the number of bytes
     // read.
     int Read(IOBuffer* buf, int buf_len);
@@ -264,6 +273,9 @@ class NET_EXPORT_PRIVATE QuicChromiumClientStream
   bool WritevStreamData(const std::vector<scoped_refptr<IOBuffer>>& buffers,
                         const std::vector<int>& lengths,
                         bool fin);
+  // Same as WriteStreamData except it retains |buf| in the send buffer instead
+  // of copying the data.
+  bool WriteStreamBuffer(IOBuffer* buf, int buf_len, bool fin);
 
   // Creates a new Handle for this stream. Must only be called once.
   std::unique_ptr<QuicChromiumClientStream::Handle> CreateHandle();
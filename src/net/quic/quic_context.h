@@ -140,6 +140,14 @@ struct NET_EXPORT QuicParams {
   // If true, sessions with open streams will attempt to migrate to a different
   // port when the current path is poor.
   bool allow_port_migration = false;
+  // If true, sessions will attempt to migrate to a different port when any
+  // local IP address changes. Unlike |migrate_sessions_on_network_change_v2|,
+  // this does not require network handles. Requires |allow_port_migration|.
+  bool migrate_sessions_on_ip_change = false;
+  // If true, QUIC proxy tunnels send written data directly out of the
+  // caller's buffers instead of copying it into the stream send buffer.
+  // Callers must not modify a buffer after writing it.
+  bool zero_copy_proxy_writes = false;
   // A session can be migrated if its idle time is within this period.
   base::TimeDelta idle_session_migration_period =
       kDefaultIdleSessionMigrationPeriod;
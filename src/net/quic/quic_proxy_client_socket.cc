@@ -30,7 +30,8 @@ QuicProxyClientSocket::QuicProxyClientSocket(
     const HostPortPair& endpoint,
     const NetLogWithSource& net_log,
     HttpAuthController* auth_controller,
-    ProxyDelegate* proxy_delegate)
+    ProxyDelegate* proxy_delegate,
+    bool zero_copy_writes)
     : next_state_(STATE_DISCONNECTED),
       stream_(std::move(stream)),
       session_(std::move(session)),
@@ -40,6 +41,7 @@ QuicProxyClientSocket::QuicProxyClientSocket(
       auth_(auth_controller),
       proxy_server_(proxy_server),
       proxy_delegate_(proxy_delegate),
+      zero_copy_writes_(zero_copy_writes),
       user_agent_(user_agent),
       use_fastopen_(false),
       read_headers_pending_(false),
@@ -234,10 +236,18 @@ int QuicProxyClientSocket::Write(
   net_log_.AddByteTransferEvent(NetLogEventType::SOCKET_BYTES_SENT, buf_len,
                                 buf->data());
 
-  int rv = stream_->WriteStreamData(
-      base::StringPiece(buf->data(), buf_len), false,
-      base::BindOnce(&QuicProxyClientSocket::OnWriteComplete,
-                     weak_factory_.GetWeakPtr()));
+  int rv;
+  if (zero_copy_writes_) {
+    rv = stream_->WriteStreamBuffer(
+        buf, buf_len, false,
+        base::BindOnce(&QuicProxyClientSocket::OnWriteComplete,
+                       weak_factory_.GetWeakPtr()));
+  } else {
+    rv = stream_->WriteStreamData(
+        base::StringPiece(buf->data(), buf_len), false,
+        base::BindOnce(&QuicProxyClientSocket::OnWriteComplete,
+                       weak_factory_.GetWeakPtr()));
+  }
   if (rv == OK)
     return buf_len;
 
@@ -38,7 +38,8 @@ class NET_EXPORT_PRIVATE QuicProxyClientSocket : public ProxyClientSocket {
       const HostPortPair& endpoint,
       const NetLogWithSource& net_log,
       HttpAuthController* auth_controller,
-      ProxyDelegate* proxy_delegate);
+      ProxyDelegate* proxy_delegate,
+      bool zero_copy_writes);
 
   // On destruction Disconnect() is called.
   ~QuicProxyClientSocket() override;
@@ -143,6 +144,9 @@ class NET_EXPORT_PRIVATE QuicProxyClientSocket : public ProxyClientSocket {
   // This delegate must outlive this proxy client socket.
   ProxyDelegate* const proxy_delegate_;
 
+  // If true, written buffers are retained by the stream instead of copied.
+  const bool zero_copy_writes_;
+
   std::string user_agent_;
 
   // Session connect timing info.
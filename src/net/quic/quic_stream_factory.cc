@@ -1162,7 +1162,8 @@ QuicStreamFactory::~QuicStreamFactory() {
   DCHECK(active_crypto_config_map_.empty());
 
   if (params_.close_sessions_on_ip_change ||
-      params_.goaway_sessions_on_ip_change) {
+      params_.goaway_sessions_on_ip_change ||
+      params_.migrate_sessions_on_ip_change) {
     NetworkChangeNotifier::RemoveIPAddressObserver(this);
   }
   if (NetworkChangeNotifier::AreNetworkHandlesSupported()) {
@@ -1493,6 +1494,17 @@ void QuicStreamFactory::OnIPAddressChanged() {
 
   connectivity_monitor_.OnIPAddressChanged();
 
+  if (params_.migrate_sessions_on_ip_change) {
+    // Sessions may be deleted while iterating through the map.
+    auto it = all_sessions_.begin();
+    while (it != all_sessions_.end()) {
+      QuicChromiumClientSession* session = it->first;
+      ++it;
+      session->OnIPAddressChanged();
+    }
+    return;
+  }
+
   set_is_quic_known_to_work_on_current_network(false);
   if (params_.close_sessions_on_ip_change) {
     CloseAllSessions(ERR_NETWORK_CHANGED, quic::QUIC_IP_ADDRESS_CHANGED);
@@ -1991,8 +2003,14 @@ void QuicStreamFactory::InitializeMigrationOptions() {
   DCHECK(!(params_.close_sessions_on_ip_change &&
            params_.goaway_sessions_on_ip_change));
 
+  DCHECK(!(params_.migrate_sessions_on_ip_change &&
+           (params_.close_sessions_on_ip_change ||
+            params_.goaway_sessions_on_ip_change)));
+  DCHECK(!params_.migrate_sessions_on_ip_change || allow_port_migration);
+
   bool handle_ip_change = params_.close_sessions_on_ip_change ||
-                          params_.goaway_sessions_on_ip_change;
+                          params_.goaway_sessions_on_ip_change ||
+                          params_.migrate_sessions_on_ip_change;
   // If IP address changes are handled explicitly, connection migration should
   // not be set.
   DCHECK(!(handle_ip_change && migrate_sessions_on_network_change));
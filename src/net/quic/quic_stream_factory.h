@@ -349,6 +349,8 @@ class NET_EXPORT_PRIVATE QuicStreamFactory
 
   bool allow_server_migration() const { return params_.allow_server_migration; }
 
+  bool zero_copy_proxy_writes() const { return params_.zero_copy_proxy_writes; }
+
   // Returns true is gQUIC 0-RTT is disabled from quic_context.
   bool gquic_zero_rtt_disabled() const {
     return params_.disable_gquic_zero_rtt;
@@ -434,16 +434,29 @@ void SocketPosix::OnFileCanWriteWithoutBlocking(int fd) {
 
 int SocketPosix::DoAccept(std::unique_ptr<SocketPosix>* socket) {
   SockaddrStorage new_peer_address;
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  // Saves the fcntl() call that would make the socket non-blocking.
+  int new_socket = HANDLE_EINTR(
+      accept4(socket_fd_, new_peer_address.addr, &new_peer_address.addr_len,
+              SOCK_NONBLOCK | SOCK_CLOEXEC));
+#else
   int new_socket = HANDLE_EINTR(accept(socket_fd_,
                                        new_peer_address.addr,
                                        &new_peer_address.addr_len));
+#endif
   if (new_socket < 0)
     return MapAcceptError(errno);
 
   std::unique_ptr<SocketPosix> accepted_socket(new SocketPosix);
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  // AdoptConnectedSocket() would make the socket non-blocking again.
+  accepted_socket->socket_fd_ = new_socket;
+  accepted_socket->SetPeerAddress(new_peer_address);
+#else
   int rv = accepted_socket->AdoptConnectedSocket(new_socket, new_peer_address);
   if (rv != OK)
     return rv;
+#endif
 
   *socket = std::move(accepted_socket);
   return OK;
@@ -395,6 +395,17 @@ int TCPSocketPosix::AllowAddressReuse() {
   return SetReuseAddr(socket_->socket_fd(), true);
 }
 
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+int TCPSocketPosix::AllowPortReuse() {
+  DCHECK(socket_);
+
+  int on = 1;
+  int rv = setsockopt(socket_->socket_fd(), SOL_SOCKET, SO_REUSEPORT, &on,
+                      sizeof(on));
+  return rv == -1 ? MapSystemError(errno) : OK;
+}
+#endif
+
 int TCPSocketPosix::SetReceiveBufferSize(int32_t size) {
   DCHECK(socket_);
 
@@ -12,6 +12,7 @@
 #include "base/callback.h"
 #include "base/compiler_specific.h"
 #include "base/macros.h"
+#include "build/build_config.h"
 #include "net/base/address_family.h"
 #include "net/base/completion_once_callback.h"
 #include "net/base/net_export.h"
@@ -113,6 +114,11 @@ class NET_EXPORT TCPSocketPosix {
   // - SetKeepAlive(true, 45).
   void SetDefaultOptionsForClient();
   int AllowAddressReuse();
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  // Sets SO_REUSEPORT before Bind(), letting several sockets listen on the
+  // same address and port. The kernel spreads new connections across them.
+  int AllowPortReuse();
+#endif
   int SetReceiveBufferSize(int32_t size);
   int SetSendBufferSize(int32_t size);
   bool SetKeepAlive(bool enable, int delay);
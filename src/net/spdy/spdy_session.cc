@@ -95,6 +95,11 @@ const int kReadBufferSize = 8 * 1024;
 const int kDefaultConnectionAtRiskOfLossSeconds = 10;
 const int kHungIntervalSeconds = 10;
 
+// With health checks enabled, a ping is considered lost after this many
+// smoothed round trip times, but never sooner than kMinPingTimeoutMs.
+const int kPingTimeoutRttMultiplier = 4;
+const int kMinPingTimeoutMs = 1000;
+
 // Lifetime of unclaimed pushed stream, in seconds: after this period, a pushed
 // stream is cancelled if still not claimed.
 const int kPushedStreamLifetimeSeconds = 300;
@@ -929,10 +934,14 @@ SpdySession::SpdySession(
     const quic::ParsedQuicVersionVector& quic_supported_versions,
     bool enable_sending_initial_data,
     bool enable_ping_based_connection_checking,
+    base::TimeDelta health_check_interval,
+    base::TimeDelta ping_timeout,
     bool is_http2_enabled,
     bool is_quic_enabled,
     size_t session_max_recv_window_size,
+    size_t session_recv_window_per_stream,
     int session_max_queued_capped_frames,
+    bool go_away_on_stream_cap,
     const spdy::SettingsMap& initial_settings,
     const absl::optional<SpdySessionPool::GreasedHttp2Frame>&
         greased_http2_frame,
@@ -981,9 +990,12 @@ SpdySession::SpdySession(
       last_read_time_(time_func()),
       last_compressed_frame_len_(0),
       check_ping_status_pending_(false),
+      health_check_pending_(false),
       session_send_window_size_(0),
       session_max_recv_window_size_(session_max_recv_window_size),
+      session_recv_window_per_stream_(session_recv_window_per_stream),
       session_max_queued_capped_frames_(session_max_queued_capped_frames),
+      go_away_on_stream_cap_(go_away_on_stream_cap),
       session_recv_window_size_(0),
       session_unacked_recv_window_bytes_(0),
       stream_initial_send_window_size_(kDefaultInitialWindowSize),
@@ -997,6 +1009,7 @@ SpdySession::SpdySession(
       enable_sending_initial_data_(enable_sending_initial_data),
       enable_ping_based_connection_checking_(
           enable_ping_based_connection_checking),
+      health_check_interval_(health_check_interval),
       is_http2_enabled_(is_http2_enabled),
       is_quic_enabled_(is_quic_enabled),
       enable_push_(IsPushEnabled(initial_settings)),
@@ -1010,6 +1023,13 @@ SpdySession::SpdySession(
     return NetLogSpdySessionParams(host_port_proxy_pair());
   });
 
+  if (!ping_timeout.is_zero())
+    hung_interval_ = ping_timeout;
+  if (!health_check_interval_.is_zero()) {
+    connection_at_risk_of_loss_time_ =
+        std::min(connection_at_risk_of_loss_time_, health_check_interval_);
+  }
+
   DCHECK(base::Contains(initial_settings_, spdy::SETTINGS_HEADER_TABLE_SIZE));
   DCHECK(
       base::Contains(initial_settings_, spdy::SETTINGS_MAX_CONCURRENT_STREAMS));
@@ -1849,6 +1869,8 @@ void SpdySession::InitializeInternal(SpdySessionPool* pool) {
     SendInitialData();
   pool_ = pool;
 
+  PlanToSendHealthCheckPing();
+
   // Bootstrap the read loop.
   base::ThreadTaskRunnerHandle::Get()->PostTask(
       FROM_HERE,
@@ -1920,6 +1942,14 @@ int SpdySession::CreateStream(const SpdyStreamRequest& request,
   *stream = new_stream->GetWeakPtr();
   InsertCreatedStream(std::move(new_stream));
 
+  if (go_away_on_stream_cap_ &&
+      active_streams_.size() + created_streams_.size() - num_pushed_streams_ >=
+          max_concurrent_streams_) {
+    // Lets the next stream request open a new session instead of stalling
+    // behind this one. This session closes after its last stream.
+    MakeUnavailable();
+  }
+
   return OK;
 }
 
@@ -2885,7 +2915,7 @@ void SpdySession::PlanToCheckPingStatus() {
       FROM_HERE,
       base::BindOnce(&SpdySession::CheckPingStatus, weak_factory_.GetWeakPtr(),
                      time_func_()),
-      hung_interval_);
+      GetPingTimeout());
 }
 
 void SpdySession::CheckPingStatus(base::TimeTicks last_check_time) {
@@ -2899,7 +2929,8 @@ void SpdySession::CheckPingStatus(base::TimeTicks last_check_time) {
   }
 
   const base::TimeTicks now = time_func_();
-  if (now > last_read_time_ + hung_interval_ ||
+  const base::TimeDelta ping_timeout = GetPingTimeout();
+  if (now > last_read_time_ + ping_timeout ||
       last_read_time_ < last_check_time) {
     check_ping_status_pending_ = false;
     DoDrainSession(ERR_HTTP2_PING_FAILED, "Failed ping.");
@@ -2907,7 +2938,7 @@ void SpdySession::CheckPingStatus(base::TimeTicks last_check_time) {
   }
 
   // Check the status of connection after a delay.
-  const base::TimeDelta delay = last_read_time_ + hung_interval_ - now;
+  const base::TimeDelta delay = last_read_time_ + ping_timeout - now;
   base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
       FROM_HERE,
       base::BindOnce(&SpdySession::CheckPingStatus, weak_factory_.GetWeakPtr(),
@@ -2915,6 +2946,45 @@ void SpdySession::CheckPingStatus(base::TimeTicks last_check_time) {
       delay);
 }
 
+base::TimeDelta SpdySession::GetPingTimeout() const {
+  if (health_check_interval_.is_zero() || smoothed_ping_rtt_.is_zero())
+    return hung_interval_;
+
+  return std::min(
+      hung_interval_,
+      std::max(smoothed_ping_rtt_ * kPingTimeoutRttMultiplier,
+               base::TimeDelta::FromMilliseconds(kMinPingTimeoutMs)));
+}
+
+void SpdySession::PlanToSendHealthCheckPing() {
+  if (health_check_interval_.is_zero() || health_check_pending_)
+    return;
+
+  health_check_pending_ = true;
+  base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+      FROM_HERE,
+      base::BindOnce(&SpdySession::SendHealthCheckPing,
+                     weak_factory_.GetWeakPtr()),
+      health_check_interval_);
+}
+
+void SpdySession::SendHealthCheckPing() {
+  CHECK(!in_io_loop_);
+  DCHECK(health_check_pending_);
+  health_check_pending_ = false;
+
+  if (availability_state_ == STATE_DRAINING)
+    return;
+
+  if (!active_streams_.empty() && !ping_in_flight_ &&
+      !check_ping_status_pending_ &&
+      time_func_() >= last_read_time_ + health_check_interval_) {
+    WritePingFrame(next_ping_id_, false);
+  }
+
+  PlanToSendHealthCheckPing();
+}
+
 spdy::SpdyStreamId SpdySession::GetNewStreamId() {
   CHECK_LE(stream_hi_water_mark_, kLastStreamId);
   spdy::SpdyStreamId id = stream_hi_water_mark_;
@@ -3003,6 +3073,7 @@ void SpdySession::InsertActivatedStream(std::unique_ptr<SpdyStream> stream) {
       active_streams_.insert(std::make_pair(stream_id, stream.get()));
   CHECK(result.second);
   ignore_result(stream.release());
+  MaybeGrowRecvWindowSize();
 }
 
 void SpdySession::DeleteStream(std::unique_ptr<SpdyStream> stream, int status) {
@@ -3239,6 +3310,11 @@ void SpdySession::OnPing(spdy::SpdyPingId unique_id, bool is_ack) {
 
   // Record RTT in histogram when there are no more pings in flight.
   base::TimeDelta ping_duration = time_func_() - last_ping_sent_time_;
+  if (smoothed_ping_rtt_.is_zero()) {
+    smoothed_ping_rtt_ = ping_duration;
+  } else {
+    smoothed_ping_rtt_ = (smoothed_ping_rtt_ * 7 + ping_duration) / 8;
+  }
   if (network_quality_estimator_) {
     network_quality_estimator_->RecordSpdyPingLatency(host_port_pair(),
                                                       ping_duration);
@@ -3761,6 +3837,28 @@ void SpdySession::DecreaseRecvWindowSize(int32_t delta_window_size) {
   });
 }
 
+void SpdySession::MaybeGrowRecvWindowSize() {
+  if (session_recv_window_per_stream_ == 0)
+    return;
+
+  uint64_t target_window_size =
+      static_cast<uint64_t>(session_recv_window_per_stream_) *
+      active_streams_.size();
+  target_window_size =
+      std::min<uint64_t>(target_window_size, spdy::kSpdyMaximumWindowSize);
+  if (target_window_size <=
+      static_cast<uint64_t>(session_max_recv_window_size_)) {
+    return;
+  }
+
+  int32_t delta_window_size =
+      static_cast<int32_t>(target_window_size) - session_max_recv_window_size_;
+  session_max_recv_window_size_ = static_cast<int32_t>(target_window_size);
+  // Counted as unacked bytes, so that WINDOW_UPDATE frames for the extra
+  // window are batched with those for consumed data.
+  IncreaseRecvWindowSize(delta_window_size);
+}
+
 void SpdySession::QueueSendStalledStream(const SpdyStream& stream) {
   DCHECK(stream.send_stalled_by_flow_control() || IsSendStalled());
   RequestPriority priority = stream.priority();
@@ -345,10 +345,14 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
               const quic::ParsedQuicVersionVector& quic_supported_versions,
               bool enable_sending_initial_data,
               bool enable_ping_based_connection_checking,
+              base::TimeDelta health_check_interval,
+              base::TimeDelta ping_timeout,
               bool is_http_enabled,
               bool is_quic_enabled,
               size_t session_max_recv_window_size,
+              size_t session_recv_window_per_stream,
               int session_max_queued_capped_frames,
+              bool go_away_on_stream_cap,
               const spdy::SettingsMap& initial_settings,
               const absl::optional<SpdySessionPool::GreasedHttp2Frame>&
                   greased_http2_frame,
@@ -831,9 +835,22 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
   void PlanToCheckPingStatus();
 
   // Check the status of the connection. It calls |CloseSessionOnError| if we
-  // haven't received any data in |kHungInterval| time period.
+  // haven't received any data in GetPingTimeout() time period.
   void CheckPingStatus(base::TimeTicks last_check_time);
 
+  // Returns how long to wait for a ping response before declaring the
+  // connection hung. Derived from the smoothed ping RTT when health checks are
+  // enabled, otherwise |hung_interval_|.
+  base::TimeDelta GetPingTimeout() const;
+
+  // Post a SendHealthCheckPing call after |health_check_interval_|. Don't post
+  // if health checks are disabled or one is already posted.
+  void PlanToSendHealthCheckPing();
+
+  // Send a ping if there are active streams and nothing has been read for
+  // |health_check_interval_|, then plan the next health check.
+  void SendHealthCheckPing();
+
   // Get a new stream id.
   spdy::SpdyStreamId GetNewStreamId();
 
@@ -1010,6 +1027,11 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
   // If session flow control is turned off, this must not be called.
   void DecreaseRecvWindowSize(int32_t delta_window_size);
 
+  // Grows the maximum session receive window to
+  // |session_recv_window_per_stream_| per active stream if that is larger.
+  // The extra window is announced with the next WINDOW_UPDATE frame.
+  void MaybeGrowRecvWindowSize();
+
   // Queue a send-stalled stream for possibly resuming once we're not
   // send-stalled anymore.
   void QueueSendStalledStream(const SpdyStream& stream);
@@ -1196,6 +1218,10 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
   // This is the last time we have sent a PING.
   base::TimeTicks last_ping_sent_time_;
 
+  // Exponentially weighted moving average of PING round trip times. Zero until
+  // the first PING ACK is received.
+  base::TimeDelta smoothed_ping_rtt_;
+
   // This is the last time we had read activity in the session.
   base::TimeTicks last_read_time_;
 
@@ -1205,6 +1231,9 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
   // True if there is a CheckPingStatus() task posted on the message loop.
   bool check_ping_status_pending_;
 
+  // True if there is a SendHealthCheckPing() task posted on the message loop.
+  bool health_check_pending_;
+
   // Current send window size.  Zero unless session flow control is turned on.
   int32_t session_send_window_size_;
 
@@ -1213,11 +1242,19 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
   // control is turned on.
   int32_t session_max_recv_window_size_;
 
+  // If nonzero, |session_max_recv_window_size_| grows to at least this much
+  // per active stream. It never shrinks.
+  const size_t session_recv_window_per_stream_;
+
   // Maximum number of capped frames that can be queued at any time.
   // Every time we try to enqueue a capped frame, we check that there aren't
   // more than this amount already queued, and close the connection if so.
   int session_max_queued_capped_frames_;
 
+  // If true, the session is made unavailable once the number of streams
+  // reaches |max_concurrent_streams_|, so that new streams go to a new session.
+  const bool go_away_on_stream_cap_;
+
   // Sum of |session_unacked_recv_window_bytes_| and current receive window
   // size.  Zero unless session flow control is turned on.
   // TODO(bnc): Rename or change semantics so that |window_size_| is actual
@@ -1258,6 +1295,10 @@ class NET_EXPORT SpdySession : public BufferedSpdyFramerVisitorInterface,
   const bool enable_sending_initial_data_;
   const bool enable_ping_based_connection_checking_;
 
+  // If nonzero, the period of health check pings. See
+  // HttpNetworkSession::Params::spdy_health_check_interval.
+  const base::TimeDelta health_check_interval_;
+
   const bool is_http2_enabled_;
   const bool is_quic_enabled_;
 
@@ -7,6 +7,7 @@
 #include <tuple>
 
 #include "base/feature_list.h"
+#include "base/hash/hash.h"
 #include "base/logging.h"
 #include "base/trace_event/memory_usage_estimator.h"
 #include "net/base/features.h"
@@ -15,7 +16,39 @@
 
 namespace net {
 
-SpdySessionKey::SpdySessionKey() = default;
+namespace {
+
+// Hashes the fields compared by operator==, except for the socket tag.
+size_t ComputeHash(const HostPortPair& host_port_pair,
+                   const ProxyServer& proxy_server,
+                   PrivacyMode privacy_mode,
+                   SpdySessionKey::IsProxySession is_proxy_session,
+                   const NetworkIsolationKey& network_isolation_key,
+                   SecureDnsPolicy secure_dns_policy) {
+  size_t hash = base::HashInts(base::FastHash(host_port_pair.host()),
+                               host_port_pair.port());
+  hash = base::HashInts(hash, proxy_server.scheme());
+  if (proxy_server.is_valid() && !proxy_server.is_direct()) {
+    const HostPortPair& proxy = proxy_server.host_port_pair();
+    hash = base::HashInts(
+        hash, base::HashInts(base::FastHash(proxy.host()), proxy.port()));
+  }
+  hash = base::HashInts(
+      hash, (static_cast<int>(privacy_mode) << 8) |
+                (static_cast<int>(is_proxy_session) << 4) |
+                static_cast<int>(secure_dns_policy));
+  return base::HashInts(hash, network_isolation_key.GetHash());
+}
+
+}  // namespace
+
+SpdySessionKey::SpdySessionKey()
+    : hash_(ComputeHash(host_port_pair(),
+                        proxy_server(),
+                        privacy_mode_,
+                        is_proxy_session_,
+                        network_isolation_key_,
+                        secure_dns_policy_)) {}
 
 SpdySessionKey::SpdySessionKey(const HostPortPair& host_port_pair,
                                const ProxyServer& proxy_server,
@@ -33,7 +66,13 @@ SpdySessionKey::SpdySessionKey(const HostPortPair& host_port_pair,
               features::kPartitionConnectionsByNetworkIsolationKey)
               ? network_isolation_key
               : NetworkIsolationKey()),
-      secure_dns_policy_(secure_dns_policy) {
+      secure_dns_policy_(secure_dns_policy),
+      hash_(ComputeHash(host_port_pair,
+                        proxy_server,
+                        privacy_mode,
+                        is_proxy_session,
+                        network_isolation_key_,
+                        secure_dns_policy)) {
   // IsProxySession::kTrue should only be used with direct connections, since
   // using multiple layers of proxies on top of each other isn't supported.
   DCHECK(is_proxy_session != IsProxySession::kTrue || proxy_server.is_direct());
@@ -57,7 +96,7 @@ bool SpdySessionKey::operator<(const SpdySessionKey& other) const {
 }
 
 bool SpdySessionKey::operator==(const SpdySessionKey& other) const {
-  return privacy_mode_ == other.privacy_mode_ &&
+  return hash_ == other.hash_ && privacy_mode_ == other.privacy_mode_ &&
          host_port_proxy_pair_.first.Equals(
              other.host_port_proxy_pair_.first) &&
          host_port_proxy_pair_.second == other.host_port_proxy_pair_.second &&
@@ -5,6 +5,8 @@
 #ifndef NET_SPDY_SPDY_SESSION_KEY_H_
 #define NET_SPDY_SPDY_SESSION_KEY_H_
 
+#include <cstddef>
+
 #include "net/base/net_export.h"
 #include "net/base/network_isolation_key.h"
 #include "net/base/privacy_mode.h"
@@ -49,6 +51,12 @@ class NET_EXPORT_PRIVATE SpdySessionKey {
   bool operator==(const SpdySessionKey& other) const;
   bool operator!=(const SpdySessionKey& other) const;
 
+  // Hasher so this can be placed in a std::unordered_map. The hash is
+  // computed once on construction.
+  struct Hash {
+    size_t operator()(const SpdySessionKey& key) const { return key.hash_; }
+  };
+
   // Struct returned by CompareForAliasing().
   struct CompareForAliasingResult {
     // True if the two SpdySessionKeys match, except possibly for their
@@ -102,11 +110,12 @@ class NET_EXPORT_PRIVATE SpdySessionKey {
   HostPortProxyPair host_port_proxy_pair_;
   // If enabled, then session cannot be tracked by the server.
   PrivacyMode privacy_mode_ = PRIVACY_MODE_DISABLED;
-  IsProxySession is_proxy_session_;
+  IsProxySession is_proxy_session_ = IsProxySession::kFalse;
   SocketTag socket_tag_;
   // Used to separate requests made in different contexts.
   NetworkIsolationKey network_isolation_key_;
-  SecureDnsPolicy secure_dns_policy_;
+  SecureDnsPolicy secure_dns_policy_ = SecureDnsPolicy::kAllow;
+  size_t hash_;
 };
 
 }  // namespace net
@@ -83,10 +83,14 @@ SpdySessionPool::SpdySessionPool(
     TransportSecurityState* transport_security_state,
     const quic::ParsedQuicVersionVector& quic_supported_versions,
     bool enable_ping_based_connection_checking,
+    base::TimeDelta health_check_interval,
+    base::TimeDelta ping_timeout,
     bool is_http2_enabled,
     bool is_quic_enabled,
     size_t session_max_recv_window_size,
+    size_t session_recv_window_per_stream,
     int session_max_queued_capped_frames,
+    bool go_away_on_stream_cap,
     const spdy::SettingsMap& initial_settings,
     const absl::optional<GreasedHttp2Frame>& greased_http2_frame,
     bool http2_end_stream_with_data_frame,
@@ -101,10 +105,14 @@ SpdySessionPool::SpdySessionPool(
       enable_sending_initial_data_(true),
       enable_ping_based_connection_checking_(
           enable_ping_based_connection_checking),
+      health_check_interval_(health_check_interval),
+      ping_timeout_(ping_timeout),
       is_http2_enabled_(is_http2_enabled),
       is_quic_enabled_(is_quic_enabled),
       session_max_recv_window_size_(session_max_recv_window_size),
+      session_recv_window_per_stream_(session_recv_window_per_stream),
       session_max_queued_capped_frames_(session_max_queued_capped_frames),
+      go_away_on_stream_cap_(go_away_on_stream_cap),
       initial_settings_(initial_settings),
       greased_http2_frame_(greased_http2_frame),
       http2_end_stream_with_data_frame_(http2_end_stream_with_data_frame),
@@ -704,12 +712,13 @@ std::unique_ptr<SpdySession> SpdySessionPool::CreateSession(
       key, http_server_properties_, transport_security_state_,
       ssl_client_context_ ? ssl_client_context_->ssl_config_service() : nullptr,
       quic_supported_versions_, enable_sending_initial_data_,
-      enable_ping_based_connection_checking_, is_http2_enabled_,
-      is_quic_enabled_, session_max_recv_window_size_,
-      session_max_queued_capped_frames_, initial_settings_,
-      greased_http2_frame_, http2_end_stream_with_data_frame_,
-      enable_priority_update_, time_func_, push_delegate_,
-      network_quality_estimator_, net_log);
+      enable_ping_based_connection_checking_, health_check_interval_,
+      ping_timeout_, is_http2_enabled_, is_quic_enabled_,
+      session_max_recv_window_size_, session_recv_window_per_stream_,
+      session_max_queued_capped_frames_, go_away_on_stream_cap_,
+      initial_settings_, greased_http2_frame_,
+      http2_end_stream_with_data_frame_, enable_priority_update_, time_func_,
+      push_delegate_, network_quality_estimator_, net_log);
 }
 
 base::WeakPtr<SpdySession> SpdySessionPool::InsertSession(
@@ -12,6 +12,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "base/macros.h"
@@ -138,10 +139,14 @@ class NET_EXPORT SpdySessionPool
                   TransportSecurityState* transport_security_state,
                   const quic::ParsedQuicVersionVector& quic_supported_versions,
                   bool enable_ping_based_connection_checking,
+                  base::TimeDelta health_check_interval,
+                  base::TimeDelta ping_timeout,
                   bool is_http_enabled,
                   bool is_quic_enabled,
                   size_t session_max_recv_window_size,
+                  size_t session_recv_window_per_stream,
                   int session_max_queued_capped_frames,
+                  bool go_away_on_stream_cap,
                   const spdy::SettingsMap& initial_settings,
                   const absl::optional<GreasedHttp2Frame>& greased_http2_frame,
                   bool http2_end_stream_with_data_frame,
@@ -321,11 +326,16 @@ class NET_EXPORT SpdySessionPool
 
   using SessionSet = std::set<SpdySession*>;
   using WeakSessionList = std::vector<base::WeakPtr<SpdySession>>;
-  using AvailableSessionMap =
-      std::map<SpdySessionKey, base::WeakPtr<SpdySession>>;
+  // Keyed by the hash precomputed in SpdySessionKey, since every tunnel looks
+  // up its proxy session here.
+  using AvailableSessionMap = std::unordered_map<SpdySessionKey,
+                                                 base::WeakPtr<SpdySession>,
+                                                 SpdySessionKey::Hash>;
   using AliasMap = std::multimap<IPEndPoint, SpdySessionKey>;
   using DnsAliasesBySessionKeyMap =
-      std::map<SpdySessionKey, std::vector<std::string>>;
+      std::unordered_map<SpdySessionKey,
+                         std::vector<std::string>,
+                         SpdySessionKey::Hash>;
   using RequestSet = std::set<SpdySessionRequest*>;
 
   struct RequestInfoForKey {
@@ -342,7 +352,9 @@ class NET_EXPORT SpdySessionPool
     std::list<base::RepeatingClosure> deferred_callbacks;
   };
 
-  using SpdySessionRequestMap = std::map<SpdySessionKey, RequestInfoForKey>;
+  using SpdySessionRequestMap = std::unordered_map<SpdySessionKey,
+                                                   RequestInfoForKey,
+                                                   SpdySessionKey::Hash>;
 
   // Removes |request| from |spdy_session_request_map_|.
   void RemoveRequestForSpdySession(SpdySessionRequest* request);
@@ -441,15 +453,20 @@ class NET_EXPORT SpdySessionPool
   // Defaults to true. May be controlled via SpdySessionPoolPeer for tests.
   bool enable_sending_initial_data_;
   bool enable_ping_based_connection_checking_;
+  const base::TimeDelta health_check_interval_;
+  const base::TimeDelta ping_timeout_;
 
   const bool is_http2_enabled_;
   const bool is_quic_enabled_;
 
   size_t session_max_recv_window_size_;
+  const size_t session_recv_window_per_stream_;
 
   // Maximum number of capped frames that can be queued at any time.
   int session_max_queued_capped_frames_;
 
+  const bool go_away_on_stream_cap_;
+
   // Settings that are sent in the initial SETTINGS frame
   // (if |enable_sending_initial_data_| is true),
   // and also control SpdySession parameters like initial receive window size
@@ -0,0 +1,56 @@
+// Copyright 2021 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/accept_limiter.h"
+
+#include <algorithm>
+
+#include "base/check_op.h"
+#include "base/containers/span.h"
+#include "base/hash/hash.h"
+#include "net/base/ip_address.h"
+#include "net/tools/naive/token_bucket.h"
+
+namespace net {
+
+namespace {
+// Must be a power of two.
+constexpr size_t kNumSlots = 4096;
+}  // namespace
+
+AcceptLimiter::AcceptLimiter(int rate,
+                             int rate_per_address,
+                             base::TimeTicks now) {
+  DCHECK_GE(rate, 0);
+  DCHECK_GE(rate_per_address, 0);
+  if (rate > 0)
+    bucket_ = std::make_unique<TokenBucket>(rate, rate, now);
+  if (rate_per_address > 0) {
+    interval_per_address_ = base::TimeDelta::FromSeconds(1) / rate_per_address;
+    tolerance_per_address_ = interval_per_address_ * (rate_per_address - 1);
+    slots_.resize(kNumSlots);
+  }
+}
+
+AcceptLimiter::~AcceptLimiter() = default;
+
+bool AcceptLimiter::TryAccept(const IPAddress& address, base::TimeTicks now) {
+  base::TimeTicks* slot = nullptr;
+  base::TimeTicks arrival_time;
+  if (!slots_.empty()) {
+    size_t hash = base::FastHash(
+        base::make_span(address.bytes().data(), address.size()));
+    slot = &slots_[hash & (kNumSlots - 1)];
+    arrival_time = std::max(*slot, now);
+    if (arrival_time - now > tolerance_per_address_)
+      return false;
+  }
+  if (bucket_ && !bucket_->TryConsume(1, now))
+    return false;
+  // Only charges the address once the connection is accepted.
+  if (slot)
+    *slot = arrival_time + interval_per_address_;
+  return true;
+}
+
+}  // namespace net
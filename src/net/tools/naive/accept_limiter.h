@@ -0,0 +1,44 @@
+// Copyright 2021 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_ACCEPT_LIMITER_H_
+#define NET_TOOLS_NAIVE_ACCEPT_LIMITER_H_
+
+#include <memory>
+#include <vector>
+
+#include "base/time/time.h"
+
+namespace net {
+
+class IPAddress;
+class TokenBucket;
+
+// Limits the rate of connections accepted by a listener, in total and per
+// client address. Client addresses are hashed into a fixed table of
+// GCRA (virtual scheduling) slots, so that colliding addresses share one
+// limit and the memory used does not grow with the number of clients.
+// Bursts of one second worth of connections are allowed.
+class AcceptLimiter {
+ public:
+  // A rate of 0 disables the respective limit.
+  AcceptLimiter(int rate, int rate_per_address, base::TimeTicks now);
+  AcceptLimiter(const AcceptLimiter&) = delete;
+  AcceptLimiter& operator=(const AcceptLimiter&) = delete;
+  ~AcceptLimiter();
+
+  // Returns false if a connection from |address| is over either limit.
+  bool TryAccept(const IPAddress& address, base::TimeTicks now);
+
+ private:
+  // Null if there is no total limit.
+  std::unique_ptr<TokenBucket> bucket_;
+  // Zero if there is no limit per address.
+  base::TimeDelta interval_per_address_;
+  base::TimeDelta tolerance_per_address_;
+  // Earliest time each slot conforms again without using its burst.
+  std::vector<base::TimeTicks> slots_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_ACCEPT_LIMITER_H_
@@ -0,0 +1,202 @@
+// Copyright 2021 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/tools/naive/async_log_sink.h"
+
+#include <cstdint>
+
+#include "base/at_exit.h"
+#include "base/bind.h"
+#include "base/check.h"
+#include "base/files/file_util.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
+
+namespace net {
+
+namespace {
+// Must be a power of two.
+constexpr size_t kRingSize = 4096;
+constexpr size_t kRingMask = kRingSize - 1;
+// Wakes up the writer early when this many messages are pushed.
+constexpr size_t kWakeUpMask = kRingSize / 2 - 1;
+constexpr size_t kMaxBatchSize = 64 * 1024;
+constexpr int kDrainIntervalMs = 100;
+constexpr int kFlushTimeoutMs = 1000;
+
+AsyncLogSink* g_sink = nullptr;
+}  // namespace
+
+// static
+bool AsyncLogSink::Install(const base::FilePath& path, int64_t max_size) {
+  DCHECK(!g_sink);
+  auto* sink = new AsyncLogSink(path, max_size);
+  if (!sink->Open()) {
+    delete sink;
+    return false;
+  }
+  if (!base::PlatformThread::Create(0, sink, &sink->thread_)) {
+    delete sink;
+    return false;
+  }
+  g_sink = sink;
+  logging::SetLogMessageHandler(&AsyncLogSink::HandleMessage);
+  // Messages logged right before main() returns would otherwise wait for the
+  // next drain, which never comes.
+  base::AtExitManager::RegisterTask(
+      base::BindOnce(&AsyncLogSink::FlushInstalled));
+  return true;
+}
+
+// static
+void AsyncLogSink::FlushInstalled() {
+  if (g_sink)
+    g_sink->Flush();
+}
+
+AsyncLogSink::AsyncLogSink(const base::FilePath& path, int64_t max_size)
+    : path_(path),
+      max_size_(max_size),
+      slots_(std::make_unique<Slot[]>(kRingSize)),
+      wake_(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+            base::WaitableEvent::InitialState::NOT_SIGNALED),
+      flushed_(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+               base::WaitableEvent::InitialState::NOT_SIGNALED) {
+  for (size_t i = 0; i < kRingSize; ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+AsyncLogSink::~AsyncLogSink() {
+  if (file_)
+    base::CloseFile(file_);
+}
+
+// static
+bool AsyncLogSink::HandleMessage(int severity,
+                                 const char* file,
+                                 int line,
+                                 size_t message_start,
+                                 const std::string& str) {
+  if (severity >= logging::LOGGING_FATAL) {
+    // Writes out everything before the crash, then lets the default handler
+    // log this message synchronously and crash.
+    g_sink->Flush();
+    return false;
+  }
+  g_sink->Push(str);
+  return true;
+}
+
+bool AsyncLogSink::Open() {
+  file_ = base::OpenFile(path_, "a");
+  if (!file_)
+    return false;
+  if (!base::GetFileSize(path_, &file_size_))
+    file_size_ = 0;
+  return true;
+}
+
+bool AsyncLogSink::Push(const std::string& message) {
+  size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+  for (;;) {
+    Slot& slot = slots_[pos & kRingMask];
+    size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    intptr_t diff =
+        static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+    if (diff == 0) {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+        slot.message = message;
+        slot.sequence.store(pos + 1, std::memory_order_release);
+        if (((pos + 1) & kWakeUpMask) == 0)
+          wake_.Signal();
+        return true;
+      }
+    } else if (diff < 0) {
+      // The ring is full.
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool AsyncLogSink::Pop(std::string* message) {
+  Slot& slot = slots_[dequeue_pos_ & kRingMask];
+  if (slot.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1)
+    return false;
+  // Swapping keeps the string capacity around in the slot for reuse.
+  message->swap(slot.message);
+  slot.message.clear();
+  slot.sequence.store(dequeue_pos_ + kRingSize, std::memory_order_release);
+  ++dequeue_pos_;
+  return true;
+}
+
+void AsyncLogSink::Drain() {
+  std::string message;
+  while (Pop(&message)) {
+    batch_ += message;
+    if (batch_.size() >= kMaxBatchSize) {
+      Write(batch_);
+      batch_.clear();
+    }
+  }
+  uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+  if (dropped > 0) {
+    batch_ += "[Dropped " + base::NumberToString(dropped) +
+              " log messages]\n";
+  }
+  if (!batch_.empty()) {
+    Write(batch_);
+    batch_.clear();
+  }
+  if (file_)
+    fflush(file_);
+}
+
+void AsyncLogSink::Write(const std::string& data) {
+  int64_t size = static_cast<int64_t>(data.size());
+  if (max_size_ > 0 && file_size_ > 0 && file_size_ + size > max_size_)
+    Rotate();
+  if (!file_)
+    return;
+  fwrite(data.data(), 1, data.size(), file_);
+  file_size_ += size;
+}
+
+void AsyncLogSink::Rotate() {
+  if (file_) {
+    base::CloseFile(file_);
+    file_ = nullptr;
+  }
+  base::ReplaceFile(path_, path_.AddExtensionASCII("1"), nullptr);
+  Open();
+  // The default handler reopens its own file handle at the new file.
+  logging::CloseLogFile();
+}
+
+void AsyncLogSink::Flush() {
+  flush_requested_.store(true, std::memory_order_release);
+  wake_.Signal();
+  flushed_.TimedWait(base::TimeDelta::FromMilliseconds(kFlushTimeoutMs));
+}
+
+void AsyncLogSink::ThreadMain() {
+  base::PlatformThread::SetName("NaiveLogWriter");
+  for (;;) {
+    wake_.TimedWait(base::TimeDelta::FromMilliseconds(kDrainIntervalMs));
+    // Takes the request before draining, so that the drain covers every
+    // message pushed before the request.
+    bool flush = flush_requested_.exchange(false, std::memory_order_acq_rel);
+    Drain();
+    if (flush)
+      flushed_.Signal();
+  }
+}
+
+}  // namespace net
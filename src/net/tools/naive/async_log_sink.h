@@ -0,0 +1,83 @@
+// Copyright 2021 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_ASYNC_LOG_SINK_H_
+#define NET_TOOLS_NAIVE_ASYNC_LOG_SINK_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
+
+namespace net {
+
+// Log message handler that moves file writes off the logging threads.
+// Formatted messages are pushed into a bounded lock-free ring and appended to
+// the log file in batches by a background writer thread. Messages are dropped
+// and counted when the ring is full. The file is rotated to "<path>.1" when it
+// grows beyond |max_size| bytes, unless |max_size| is 0.
+class AsyncLogSink : public base::PlatformThread::Delegate {
+ public:
+  // Installs a process-wide sink as the logging message handler. The sink is
+  // never destroyed, but is flushed by the AtExitManager, which must exist.
+  // Returns false if the log file cannot be opened.
+  static bool Install(const base::FilePath& path, int64_t max_size);
+
+  // Writes out the messages logged so far, waiting up to a second for the
+  // writer thread. Does nothing if no sink is installed.
+  static void FlushInstalled();
+
+  AsyncLogSink(const AsyncLogSink&) = delete;
+  AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+
+ private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    std::string message;
+  };
+
+  AsyncLogSink(const base::FilePath& path, int64_t max_size);
+  ~AsyncLogSink() override;
+
+  static bool HandleMessage(int severity,
+                            const char* file,
+                            int line,
+                            size_t message_start,
+                            const std::string& str);
+
+  bool Open();
+  bool Push(const std::string& message);
+  bool Pop(std::string* message);
+  void Drain();
+  void Write(const std::string& data);
+  void Rotate();
+  void Flush();
+
+  // base::PlatformThread::Delegate implementation.
+  void ThreadMain() override;
+
+  const base::FilePath path_;
+  const int64_t max_size_;
+  FILE* file_ = nullptr;
+  int64_t file_size_ = 0;
+
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<size_t> enqueue_pos_{0};
+  // Only accessed by the writer thread.
+  size_t dequeue_pos_ = 0;
+  std::atomic<uint64_t> dropped_{0};
+
+  base::WaitableEvent wake_;
+  base::WaitableEvent flushed_;
+  std::atomic<bool> flush_requested_{false};
+  base::PlatformThreadHandle thread_;
+  std::string batch_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_ASYNC_LOG_SINK_H_
@@ -0,0 +1,296 @@
+// Copyright 2021 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/compressed_socket.h"
+
+#include <cstring>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/check.h"
+#include "net/base/net_errors.h"
+
+namespace net {
+
+namespace {
+constexpr int kReadBufferSize = 32 * 1024;
+// Fast, since tunnels carry bulk data.
+constexpr int kCompressionLevel = 1;
+// Raw DEFLATE, without zlib or gzip wrappers.
+constexpr int kWindowBits = -15;
+constexpr int kMemLevel = 8;
+// A write smaller than this says little about how compressible the data is.
+constexpr int kMinProbeSize = 1024;
+// Writes saving less than 1/16 of their size are considered incompressible.
+constexpr int kMinSavingShift = 4;
+// Incompressible data is sent as stored blocks for this many bytes before
+// compression is tried again.
+constexpr int64_t kBypassSize = 1024 * 1024;
+}  // namespace
+
+CompressedSocket::CompressedSocket(
+    StreamSocket* transport,
+    const NetworkTrafficAnnotationTag& traffic_annotation)
+    : transport_(transport),
+      traffic_annotation_(traffic_annotation),
+      inflate_initialized_(false),
+      deflate_initialized_(false),
+      deflate_level_(kCompressionLevel),
+      bypass_bytes_left_(0),
+      read_buffer_(base::MakeRefCounted<IOBuffer>(kReadBufferSize)),
+      user_read_buf_len_(0),
+      user_write_size_(0) {
+  DCHECK(transport_);
+  std::memset(&inflate_stream_, 0, sizeof(inflate_stream_));
+  std::memset(&deflate_stream_, 0, sizeof(deflate_stream_));
+}
+
+CompressedSocket::~CompressedSocket() {
+  if (inflate_initialized_)
+    inflateEnd(&inflate_stream_);
+  if (deflate_initialized_)
+    deflateEnd(&deflate_stream_);
+}
+
+bool CompressedSocket::Init() {
+  if (inflateInit2(&inflate_stream_, kWindowBits) != Z_OK)
+    return false;
+  inflate_initialized_ = true;
+  if (deflateInit2(&deflate_stream_, deflate_level_, Z_DEFLATED, kWindowBits,
+                   kMemLevel, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
+  }
+  deflate_initialized_ = true;
+  return true;
+}
+
+int CompressedSocket::Connect(CompletionOnceCallback callback) {
+  return transport_->Connect(std::move(callback));
+}
+
+void CompressedSocket::Disconnect() {
+  transport_->Disconnect();
+  weak_ptr_factory_.InvalidateWeakPtrs();
+  user_read_buf_ = nullptr;
+  read_callback_.Reset();
+  write_buffer_ = nullptr;
+  write_callback_.Reset();
+}
+
+bool CompressedSocket::IsConnected() const {
+  return transport_->IsConnected();
+}
+
+bool CompressedSocket::IsConnectedAndIdle() const {
+  return inflate_stream_.avail_in == 0 && transport_->IsConnectedAndIdle();
+}
+
+const NetLogWithSource& CompressedSocket::NetLog() const {
+  return transport_->NetLog();
+}
+
+bool CompressedSocket::WasEverUsed() const {
+  return transport_->WasEverUsed();
+}
+
+bool CompressedSocket::WasAlpnNegotiated() const {
+  return transport_->WasAlpnNegotiated();
+}
+
+NextProto CompressedSocket::GetNegotiatedProtocol() const {
+  return transport_->GetNegotiatedProtocol();
+}
+
+bool CompressedSocket::GetSSLInfo(SSLInfo* ssl_info) {
+  return transport_->GetSSLInfo(ssl_info);
+}
+
+void CompressedSocket::GetConnectionAttempts(ConnectionAttempts* out) const {
+  out->clear();
+}
+
+int64_t CompressedSocket::GetTotalReceivedBytes() const {
+  return transport_->GetTotalReceivedBytes();
+}
+
+void CompressedSocket::ApplySocketTag(const SocketTag& tag) {
+  return transport_->ApplySocketTag(tag);
+}
+
+int CompressedSocket::Read(IOBuffer* buf,
+                           int buf_len,
+                           CompletionOnceCallback callback) {
+  DCHECK(inflate_initialized_);
+  DCHECK(!read_callback_);
+  DCHECK_GT(buf_len, 0);
+
+  user_read_buf_ = buf;
+  user_read_buf_len_ = buf_len;
+  // Output left over from the last read is returned first.
+  int rv = Inflate();
+  if (rv == 0)
+    rv = DoRead();
+  if (rv == ERR_IO_PENDING) {
+    read_callback_ = std::move(callback);
+  } else {
+    user_read_buf_ = nullptr;
+  }
+  return rv;
+}
+
+int CompressedSocket::Inflate() {
+  inflate_stream_.next_out = reinterpret_cast<Bytef*>(user_read_buf_->data());
+  inflate_stream_.avail_out = user_read_buf_len_;
+  int ret = inflate(&inflate_stream_, Z_SYNC_FLUSH);
+  // Z_BUF_ERROR only means no progress was possible.
+  if (ret != Z_OK && ret != Z_BUF_ERROR)
+    return ERR_CONTENT_DECODING_FAILED;
+  return user_read_buf_len_ - inflate_stream_.avail_out;
+}
+
+int CompressedSocket::DoRead() {
+  for (;;) {
+    DCHECK_EQ(inflate_stream_.avail_in, 0u);
+    int rv = transport_->Read(
+        read_buffer_.get(), kReadBufferSize,
+        base::BindOnce(&CompressedSocket::OnReadComplete,
+                       weak_ptr_factory_.GetWeakPtr()));
+    // Returns end of stream and errors as they are.
+    if (rv <= 0)
+      return rv;
+    inflate_stream_.next_in = reinterpret_cast<Bytef*>(read_buffer_->data());
+    inflate_stream_.avail_in = rv;
+    rv = Inflate();
+    // Reads again if the input only completed a block header.
+    if (rv != 0)
+      return rv;
+  }
+}
+
+void CompressedSocket::OnReadComplete(int result) {
+  if (result > 0) {
+    inflate_stream_.next_in = reinterpret_cast<Bytef*>(read_buffer_->data());
+    inflate_stream_.avail_in = result;
+    result = Inflate();
+    if (result == 0)
+      result = DoRead();
+  }
+  if (result == ERR_IO_PENDING)
+    return;
+  user_read_buf_ = nullptr;
+  std::move(read_callback_).Run(result);
+}
+
+int CompressedSocket::Write(
+    IOBuffer* buf,
+    int buf_len,
+    CompletionOnceCallback callback,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  DCHECK(deflate_initialized_);
+  DCHECK(!write_callback_);
+  DCHECK_GT(buf_len, 0);
+
+  // The transport may hold on to the written buffer after the write
+  // completes, e.g. QUIC streams with zero_copy_proxy_writes until the data
+  // is acked, so each write gets a buffer of its own.
+  auto output = base::MakeRefCounted<GrowableIOBuffer>();
+  int rv = Deflate(buf->data(), buf_len, output.get());
+  if (rv < 0)
+    return rv;
+  write_buffer_ =
+      base::MakeRefCounted<DrainableIOBuffer>(std::move(output), rv);
+  user_write_size_ = buf_len;
+  rv = DoWrite();
+  if (rv == ERR_IO_PENDING)
+    write_callback_ = std::move(callback);
+  return rv;
+}
+
+int CompressedSocket::Deflate(const char* data,
+                              int size,
+                              GrowableIOBuffer* output) {
+  int level = bypass_bytes_left_ > 0 ? 0 : kCompressionLevel;
+
+  int capacity = static_cast<int>(
+      deflateBound(&deflate_stream_, static_cast<uLong>(size)) + 16);
+  output->SetCapacity(capacity);
+  deflate_stream_.next_out = reinterpret_cast<Bytef*>(output->StartOfBuffer());
+  deflate_stream_.avail_out = capacity;
+
+  // The last sync flush left nothing pending, so switching the level does not
+  // emit a block of its own.
+  if (level != deflate_level_) {
+    if (deflateParams(&deflate_stream_, level, Z_DEFAULT_STRATEGY) != Z_OK)
+      return ERR_UNEXPECTED;
+    deflate_level_ = level;
+  }
+
+  deflate_stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  deflate_stream_.avail_in = size;
+  for (;;) {
+    int ret = deflate(&deflate_stream_, Z_SYNC_FLUSH);
+    if (ret != Z_OK && ret != Z_BUF_ERROR)
+      return ERR_UNEXPECTED;
+    // The flush is complete when there is output space left.
+    if (deflate_stream_.avail_out > 0)
+      break;
+    output->SetCapacity(capacity * 2);
+    deflate_stream_.next_out =
+        reinterpret_cast<Bytef*>(output->StartOfBuffer() + capacity);
+    deflate_stream_.avail_out = capacity;
+    capacity *= 2;
+  }
+  DCHECK_EQ(deflate_stream_.avail_in, 0u);
+  int compressed_size = capacity - deflate_stream_.avail_out;
+
+  if (bypass_bytes_left_ > 0) {
+    bypass_bytes_left_ -= size;
+  } else if (size >= kMinProbeSize &&
+             size - compressed_size < (size >> kMinSavingShift)) {
+    bypass_bytes_left_ = kBypassSize;
+  }
+  return compressed_size;
+}
+
+int CompressedSocket::DoWrite() {
+  while (write_buffer_->BytesRemaining() > 0) {
+    int rv = transport_->Write(
+        write_buffer_.get(), write_buffer_->BytesRemaining(),
+        base::BindOnce(&CompressedSocket::OnWriteComplete,
+                       weak_ptr_factory_.GetWeakPtr()),
+        traffic_annotation_);
+    if (rv < 0)
+      return rv;
+    write_buffer_->DidConsume(rv);
+  }
+  write_buffer_ = nullptr;
+  return user_write_size_;
+}
+
+void CompressedSocket::OnWriteComplete(int result) {
+  if (result >= 0) {
+    write_buffer_->DidConsume(result);
+    result = DoWrite();
+  }
+  if (result == ERR_IO_PENDING)
+    return;
+  std::move(write_callback_).Run(result);
+}
+
+int CompressedSocket::SetReceiveBufferSize(int32_t size) {
+  return transport_->SetReceiveBufferSize(size);
+}
+
+int CompressedSocket::SetSendBufferSize(int32_t size) {
+  return transport_->SetSendBufferSize(size);
+}
+
+int CompressedSocket::GetPeerAddress(IPEndPoint* address) const {
+  return transport_->GetPeerAddress(address);
+}
+
+int CompressedSocket::GetLocalAddress(IPEndPoint* address) const {
+  return transport_->GetLocalAddress(address);
+}
+
+}  // namespace net
@@ -0,0 +1,113 @@
+// Copyright 2021 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_COMPRESSED_SOCKET_H_
+#define NET_TOOLS_NAIVE_COMPRESSED_SOCKET_H_
+
+#include <cstdint>
+
+#include "base/memory/scoped_refptr.h"
+#include "base/memory/weak_ptr.h"
+#include "net/base/completion_once_callback.h"
+#include "net/base/io_buffer.h"
+#include "net/base/ip_endpoint.h"
+#include "net/log/net_log_with_source.h"
+#include "net/socket/connection_attempts.h"
+#include "net/socket/next_proto.h"
+#include "net/socket/stream_socket.h"
+#include "net/ssl/ssl_info.h"
+#include "third_party/zlib/zlib.h"
+
+namespace net {
+struct NetworkTrafficAnnotationTag;
+
+// Compresses the data written to a tunnel and decompresses the data read
+// from it, as raw DEFLATE streams (RFC 1951) in each direction. Every write
+// ends with a sync flush, so the peer can decompress it right away. Writes
+// that do not compress switch the stream to stored blocks for a while.
+//
+// The sizes of compressed writes depend on their content and are visible
+// through the encryption of the proxy connection. This leaks secrets in
+// attacker-influenced plaintext, as in CRIME, and compresses away padding.
+// Only for trusted bulk traffic that carries no secrets.
+class CompressedSocket : public StreamSocket {
+ public:
+  // |transport| must outlive this socket.
+  CompressedSocket(StreamSocket* transport,
+                   const NetworkTrafficAnnotationTag& traffic_annotation);
+  CompressedSocket(const CompressedSocket&) = delete;
+  CompressedSocket& operator=(const CompressedSocket&) = delete;
+  ~CompressedSocket() override;
+
+  // Returns false if zlib cannot be initialized.
+  bool Init();
+
+  // StreamSocket implementation.
+  int Connect(CompletionOnceCallback callback) override;
+  void Disconnect() override;
+  bool IsConnected() const override;
+  bool IsConnectedAndIdle() const override;
+  const NetLogWithSource& NetLog() const override;
+  bool WasEverUsed() const override;
+  bool WasAlpnNegotiated() const override;
+  NextProto GetNegotiatedProtocol() const override;
+  bool GetSSLInfo(SSLInfo* ssl_info) override;
+  void GetConnectionAttempts(ConnectionAttempts* out) const override;
+  void ClearConnectionAttempts() override {}
+  void AddConnectionAttempts(const ConnectionAttempts& attempts) override {}
+  int64_t GetTotalReceivedBytes() const override;
+  void ApplySocketTag(const SocketTag& tag) override;
+
+  // Socket implementation.
+  int Read(IOBuffer* buf,
+           int buf_len,
+           CompletionOnceCallback callback) override;
+  int Write(IOBuffer* buf,
+            int buf_len,
+            CompletionOnceCallback callback,
+            const NetworkTrafficAnnotationTag& traffic_annotation) override;
+
+  int SetReceiveBufferSize(int32_t size) override;
+  int SetSendBufferSize(int32_t size) override;
+
+  int GetPeerAddress(IPEndPoint* address) const override;
+  int GetLocalAddress(IPEndPoint* address) const override;
+
+ private:
+  // Returns the number of bytes decompressed into |user_read_buf_|, 0 if more
+  // input is needed, or an error.
+  int Inflate();
+  int DoRead();
+  void OnReadComplete(int result);
+  // Compresses |size| bytes into |output|. Returns the compressed size or an
+  // error.
+  int Deflate(const char* data, int size, GrowableIOBuffer* output);
+  int DoWrite();
+  void OnWriteComplete(int result);
+
+  StreamSocket* transport_;
+  const NetworkTrafficAnnotationTag& traffic_annotation_;
+
+  z_stream inflate_stream_;
+  z_stream deflate_stream_;
+  bool inflate_initialized_;
+  bool deflate_initialized_;
+  int deflate_level_;
+  // Input bytes left to send as stored blocks before compressing again.
+  int64_t bypass_bytes_left_;
+
+  scoped_refptr<IOBuffer> read_buffer_;
+  scoped_refptr<IOBuffer> user_read_buf_;
+  int user_read_buf_len_;
+  CompletionOnceCallback read_callback_;
+
+  scoped_refptr<DrainableIOBuffer> write_buffer_;
+  // The uncompressed size reported to the writer.
+  int user_write_size_;
+  CompletionOnceCallback write_callback_;
+
+  base::WeakPtrFactory<CompressedSocket> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_COMPRESSED_SOCKET_H_
@@ -19,6 +19,7 @@
 #include "net/log/net_log.h"
 #include "net/third_party/quiche/src/spdy/core/hpack/hpack_constants.h"
 #include "net/tools/naive/naive_proxy_delegate.h"
+#include "net/tools/naive/padding_policy.h"
 
 namespace net {
 
@@ -27,6 +28,7 @@ constexpr int kBufferSize = 64 * 1024;
 constexpr size_t kMaxHeaderSize = 64 * 1024;
 constexpr char kResponseHeader[] = "HTTP/1.1 200 OK\r\nPadding: ";
 constexpr int kResponseHeaderSize = sizeof(kResponseHeader) - 1;
+constexpr char kPaddingPolicyHeader[] = "\r\nPadding-Policy: ";
 // A plain 200 is 10 bytes. Expected 48 bytes. "Padding" uses up 7 bytes.
 constexpr int kMinPaddingSize = 30;
 constexpr int kMaxPaddingSize = kMinPaddingSize + 32;
@@ -55,6 +57,10 @@ const HostPortPair& HttpProxySocket::request_endpoint() const {
   return request_endpoint_;
 }
 
+const StreamSocket* HttpProxySocket::transport_socket() const {
+  return transport_.get();
+}
+
 int HttpProxySocket::Connect(CompletionOnceCallback callback) {
   DCHECK(transport_);
   DCHECK_EQ(STATE_NONE, next_state_);
@@ -308,6 +314,14 @@ int HttpProxySocket::DoHeaderReadComplete(int result) {
   if (headers.HasHeader("padding")) {
     padding_detector_delegate_->SetClientPaddingSupport(
         PaddingSupport::kCapable);
+    PaddingPolicy padding_policy;
+    std::string padding_policy_spec;
+    if (headers.GetHeader("padding-policy", &padding_policy_spec)) {
+      if (!PaddingPolicy::Parse(padding_policy_spec, &padding_policy))
+        return ERR_INVALID_ARGUMENT;
+      padding_policy_spec_ = padding_policy.ToString();
+    }
+    padding_detector_delegate_->SetClientPaddingPolicy(padding_policy);
   } else {
     padding_detector_delegate_->SetClientPaddingSupport(
         PaddingSupport::kIncapable);
@@ -315,6 +329,9 @@ int HttpProxySocket::DoHeaderReadComplete(int result) {
 
   buffer_ = buffer_.substr(header_end + 4);
 
+  if (request_endpoint_callback_)
+    std::move(request_endpoint_callback_).Run();
+
   next_state_ = STATE_HEADER_WRITE;
   return OK;
 }
@@ -324,13 +341,20 @@ int HttpProxySocket::DoHeaderWrite() {
 
   // Adds padding.
   int padding_size = base::RandInt(kMinPaddingSize, kMaxPaddingSize);
-  header_write_size_ = kResponseHeaderSize + padding_size + 4;
+  std::string padding_policy_line;
+  if (!padding_policy_spec_.empty())
+    padding_policy_line = kPaddingPolicyHeader + padding_policy_spec_;
+  header_write_size_ =
+      kResponseHeaderSize + padding_size + padding_policy_line.size() + 4;
   handshake_buf_ = base::MakeRefCounted<IOBuffer>(header_write_size_);
   char* p = handshake_buf_->data();
   std::memcpy(p, kResponseHeader, kResponseHeaderSize);
-  FillNonindexHeaderValue(base::RandUint64(), p + kResponseHeaderSize,
-                          padding_size);
-  std::memcpy(p + kResponseHeaderSize + padding_size, "\r\n\r\n", 4);
+  p += kResponseHeaderSize;
+  FillNonindexHeaderValue(base::RandUint64(), p, padding_size);
+  p += padding_size;
+  std::memcpy(p, padding_policy_line.data(), padding_policy_line.size());
+  p += padding_policy_line.size();
+  std::memcpy(p, "\r\n\r\n", 4);
 
   return transport_->Write(handshake_buf_.get(), header_write_size_,
                            io_callback_, traffic_annotation_);
@@ -10,7 +10,9 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
 
+#include "base/callback.h"
 #include "base/macros.h"
 #include "base/memory/scoped_refptr.h"
 #include "net/base/completion_once_callback.h"
@@ -39,6 +41,13 @@ class HttpProxySocket : public StreamSocket {
   ~HttpProxySocket() override;
 
   const HostPortPair& request_endpoint() const;
+  const StreamSocket* transport_socket() const;
+
+  // Sets a callback run during Connect() as soon as request_endpoint() is
+  // known, before the reply to the client is written.
+  void set_request_endpoint_callback(base::OnceClosure callback) {
+    request_endpoint_callback_ = std::move(callback);
+  }
 
   // StreamSocket implementation.
 
@@ -111,8 +120,12 @@ class HttpProxySocket : public StreamSocket {
   bool completed_handshake_;
   bool was_ever_used_;
   int header_write_size_;
+  // The padding policy the client proposed, echoed back as agreed. Empty if
+  // the client pads by the default policy.
+  std::string padding_policy_spec_;
 
   HostPortPair request_endpoint_;
+  base::OnceClosure request_endpoint_callback_;
 
   NetLogWithSource net_log_;
 
@@ -5,6 +5,8 @@
 
 #include "net/tools/naive/naive_connection.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstring>
 #include <utility>
 
@@ -13,19 +15,27 @@
 #include "base/logging.h"
 #include "base/rand_util.h"
 #include "base/strings/strcat.h"
+#include "base/strings/stringprintf.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "net/base/io_buffer.h"
 #include "net/base/load_flags.h"
 #include "net/base/net_errors.h"
 #include "net/base/privacy_mode.h"
+#include "net/http/http_response_headers.h"
+#include "net/http/http_response_info.h"
+#include "net/http/proxy_client_socket.h"
 #include "net/proxy_resolution/proxy_info.h"
 #include "net/socket/client_socket_handle.h"
 #include "net/socket/client_socket_pool_manager.h"
 #include "net/socket/stream_socket.h"
+#include "net/socket/tcp_client_socket.h"
 #include "net/spdy/spdy_session.h"
+#include "net/tools/naive/compressed_socket.h"
 #include "net/tools/naive/http_proxy_socket.h"
 #include "net/tools/naive/redirect_resolver.h"
 #include "net/tools/naive/socks5_server_socket.h"
+#include "net/tools/naive/token_bucket.h"
+#include "net/tools/naive/tunnel_stream_request.h"
 
 #if defined(OS_LINUX)
 #include <linux/netfilter_ipv4.h>
@@ -34,16 +44,39 @@
 
 #include "net/base/ip_endpoint.h"
 #include "net/base/sockaddr_storage.h"
-#include "net/socket/tcp_client_socket.h"
+#endif
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+#include <netinet/tcp.h>
+#include <sys/socket.h>
 #endif
 
 namespace net {
 
 namespace {
 constexpr int kBufferSize = 64 * 1024;
-constexpr int kFirstPaddings = 8;
 constexpr int kPaddingHeaderSize = 3;
-constexpr int kMaxPaddingSize = 255;
+constexpr int kMinBufferSize = 16 * 1024;
+constexpr int kTcpInfoSampleIntervalSeconds = 1;
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+bool GetTcpInfo(int fd, uint32_t* rtt_us, uint32_t* cwnd, uint32_t* mss,
+                uint32_t* total_retrans) {
+  tcp_info info;
+  socklen_t info_len = sizeof(info);
+  if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &info_len) != 0)
+    return false;
+  constexpr size_t kMinInfoLen =
+      offsetof(tcp_info, tcpi_total_retrans) + sizeof(info.tcpi_total_retrans);
+  if (info_len < static_cast<socklen_t>(kMinInfoLen))
+    return false;
+  *rtt_us = info.tcpi_rtt;
+  *cwnd = info.tcpi_snd_cwnd;
+  *mss = info.tcpi_snd_mss;
+  *total_retrans = info.tcpi_total_retrans;
+  return true;
+}
+#endif
 }  // namespace
 
 NaiveConnection::NaiveConnection(
@@ -56,6 +89,11 @@ NaiveConnection::NaiveConnection(
     RedirectResolver* resolver,
     HttpNetworkSession* session,
     const NetworkIsolationKey& network_isolation_key,
+    const NetworkIsolationKey* hedge_network_isolation_key,
+    base::TimeDelta hedge_delay,
+    base::TimeDelta connect_timeout,
+    RequestPriority priority,
+    TokenBucket* rate_limiter,
     const NetLogWithSource& net_log,
     std::unique_ptr<StreamSocket> accepted_socket,
     const NetworkTrafficAnnotationTag& traffic_annotation)
@@ -68,23 +106,37 @@ NaiveConnection::NaiveConnection(
       resolver_(resolver),
       session_(session),
       network_isolation_key_(network_isolation_key),
+      hedge_network_isolation_key_(hedge_network_isolation_key),
+      hedge_delay_(hedge_delay),
+      connect_timeout_(connect_timeout),
+      priority_(priority),
+      rate_limiter_(rate_limiter),
       net_log_(net_log),
       next_state_(STATE_NONE),
       client_socket_(std::move(accepted_socket)),
       server_socket_handle_(std::make_unique<ClientSocketHandle>()),
+      hedge_pending_(false),
+      primary_connect_result_(ERR_IO_PENDING),
+      early_connect_started_(false),
+      early_connect_result_(ERR_IO_PENDING),
       sockets_{client_socket_.get(), nullptr},
       errors_{OK, OK},
       write_pending_{false, false},
+      tcp_fds_{-1, -1},
+      read_buffer_sizes_{kBufferSize, kBufferSize},
       early_pull_pending_(false),
       can_push_to_server_(false),
       early_pull_result_(ERR_IO_PENDING),
       num_paddings_{0, 0},
+      padding_bytes_{0, 0},
+      payload_bytes_{0, 0},
       read_padding_state_(STATE_READ_PAYLOAD_LENGTH_1),
       full_duplex_(false),
       time_func_(&base::TimeTicks::Now),
       traffic_annotation_(traffic_annotation) {
   io_callback_ = base::BindRepeating(&NaiveConnection::OnIOComplete,
                                      weak_ptr_factory_.GetWeakPtr());
+  last_activity_time_ = time_func_();
 }
 
 NaiveConnection::~NaiveConnection() {
@@ -110,9 +162,17 @@ int NaiveConnection::Connect(CompletionOnceCallback callback) {
 
 void NaiveConnection::Disconnect() {
   full_duplex_ = false;
+  connect_timer_.Stop();
+  hedge_timer_.Stop();
+  hedge_socket_handle_.reset();
+  hedge_pending_ = false;
+  tunnel_stream_request_.reset();
   // Closes server side first because latency is higher.
-  if (server_socket_handle_->socket())
+  if (server_compressed_socket_) {
+    server_compressed_socket_->Disconnect();
+  } else if (server_socket_handle_->socket()) {
     server_socket_handle_->socket()->Disconnect();
+  }
   client_socket_->Disconnect();
 
   next_state_ = STATE_NONE;
@@ -170,6 +230,17 @@ int NaiveConnection::DoLoop(int last_io_result) {
 int NaiveConnection::DoConnectClient() {
   next_state_ = STATE_CONNECT_CLIENT_COMPLETE;
 
+  // Connects to the server while the reply to the client is being written.
+  auto callback = base::BindOnce(&NaiveConnection::StartEarlyConnect,
+                                 weak_ptr_factory_.GetWeakPtr());
+  if (protocol_ == ClientProtocol::kSocks5) {
+    static_cast<Socks5ServerSocket*>(client_socket_.get())
+        ->set_request_endpoint_callback(std::move(callback));
+  } else if (protocol_ == ClientProtocol::kHttp) {
+    static_cast<HttpProxySocket*>(client_socket_.get())
+        ->set_request_endpoint_callback(std::move(callback));
+  }
+
   return client_socket_->Connect(io_callback_);
 }
 
@@ -201,9 +272,25 @@ int NaiveConnection::DoConnectClientComplete(int result) {
   return OK;
 }
 
-int NaiveConnection::DoConnectServer() {
-  next_state_ = STATE_CONNECT_SERVER_COMPLETE;
+void NaiveConnection::StartEarlyConnect() {
+  DCHECK_EQ(next_state_, STATE_CONNECT_CLIENT_COMPLETE);
+  early_connect_started_ = true;
+  early_connect_result_ = DetermineOrigin();
+  if (early_connect_result_ != OK)
+    return;
+  early_connect_result_ = StartServerConnect(
+      base::BindOnce(&NaiveConnection::OnEarlyConnectComplete,
+                     weak_ptr_factory_.GetWeakPtr()));
+}
 
+void NaiveConnection::OnEarlyConnectComplete(int result) {
+  early_connect_result_ = result;
+  // Resumes the state machine if it is already waiting for this connect.
+  if (next_state_ == STATE_CONNECT_SERVER_COMPLETE)
+    OnIOComplete(result);
+}
+
+int NaiveConnection::DetermineOrigin() {
   HostPortPair origin;
   if (protocol_ == ClientProtocol::kSocks5) {
     const auto* socket =
@@ -249,26 +336,248 @@ int NaiveConnection::DoConnectServer() {
 
   LOG(INFO) << "Connection " << id_ << " to " << origin.ToString();
 
+  origin_ = origin;
+  return OK;
+}
+
+int NaiveConnection::StartServerConnect(CompletionOnceCallback callback) {
+  connect_server_start_time_ = time_func_();
+  // A warm HTTP/2 proxy session only needs a new stream for the tunnel.
+  tunnel_stream_request_ = TunnelStreamRequest::CreateIfSessionAvailable(
+      origin_, session_, priority_, proxy_info_, network_isolation_key_,
+      net_log_, traffic_annotation_);
+  if (tunnel_stream_request_) {
+    return tunnel_stream_request_->Start(server_socket_handle_.get(),
+                                         std::move(callback));
+  }
   // Ignores socket limit set by socket pool for this type of socket.
   return InitSocketHandleForRawConnect2(
-      origin, session_, LOAD_IGNORE_LIMITS, MAXIMUM_PRIORITY, proxy_info_,
+      origin_, session_, LOAD_IGNORE_LIMITS, priority_, proxy_info_,
       server_ssl_config_, proxy_ssl_config_, PRIVACY_MODE_DISABLED,
       network_isolation_key_, net_log_, server_socket_handle_.get(),
-      io_callback_);
+      std::move(callback));
+}
+
+int NaiveConnection::DoConnectServer() {
+  next_state_ = STATE_CONNECT_SERVER_COMPLETE;
+
+  int rv;
+  if (early_connect_started_) {
+    rv = early_connect_result_;
+  } else {
+    rv = DetermineOrigin();
+    if (rv != OK)
+      return rv;
+    rv = StartServerConnect(io_callback_);
+  }
+  if (rv != ERR_IO_PENDING)
+    return rv;
+
+  // An early connect has already used up part of the delays.
+  base::TimeDelta elapsed = time_func_() - connect_server_start_time_;
+  if (!connect_timeout_.is_zero()) {
+    connect_timer_.Start(
+        FROM_HERE, std::max(connect_timeout_ - elapsed, base::TimeDelta()),
+        base::BindOnce(&NaiveConnection::OnConnectTimeout,
+                       weak_ptr_factory_.GetWeakPtr()));
+  }
+  if (hedge_network_isolation_key_) {
+    hedge_timer_.Start(
+        FROM_HERE, std::max(hedge_delay_ - elapsed, base::TimeDelta()),
+        base::BindOnce(&NaiveConnection::StartHedgeConnect,
+                       weak_ptr_factory_.GetWeakPtr()));
+  }
+  return rv;
 }
 
 int NaiveConnection::DoConnectServerComplete(int result) {
+  if (result < 0 && hedge_pending_) {
+    // Lets the hedged connect decide the outcome.
+    primary_connect_result_ = result;
+    next_state_ = STATE_CONNECT_SERVER_COMPLETE;
+    return ERR_IO_PENDING;
+  }
+
+  connect_timer_.Stop();
+  hedge_timer_.Stop();
+  hedge_socket_handle_.reset();
+  hedge_pending_ = false;
+  tunnel_stream_request_.reset();
+
   if (result < 0)
     return result;
 
   DCHECK(server_socket_handle_->socket());
   sockets_[kServer] = server_socket_handle_->socket();
+  connect_server_duration_ = time_func_() - connect_server_start_time_;
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  // Streams on a proxy session share one transport, so only direct
+  // connections have a TCP leg of their own on the server side.
+  const auto* client_transport = GetClientTransportSocket();
+  if (client_transport) {
+    tcp_fds_[kClient] = static_cast<const TCPClientSocket*>(client_transport)
+                            ->SocketDescriptorForTesting();
+  }
+  if (proxy_info_.is_direct()) {
+    tcp_fds_[kServer] =
+        static_cast<const TCPClientSocket*>(sockets_[kServer])
+            ->SocketDescriptorForTesting();
+  }
+#endif
+
+  // Proxy tunnels that need their own response to decide how to frame data
+  // are not fast opened, so the response is here by now.
+  if (proxy_info_.is_http() || proxy_info_.is_https() ||
+      proxy_info_.is_quic()) {
+    const HttpResponseInfo* response =
+        static_cast<ProxyClientSocket*>(server_socket_handle_->socket())
+            ->GetConnectResponseInfo();
+    if (response && response->headers) {
+      padding_detector_delegate_->SetServerTunnelResponse(*response->headers);
+    }
+  }
+
+  if (padding_detector_delegate_->IsServerCompressionEnabled()) {
+    server_compressed_socket_ = std::make_unique<CompressedSocket>(
+        sockets_[kServer], traffic_annotation_);
+    if (!server_compressed_socket_->Init())
+      return ERR_UNEXPECTED;
+    sockets_[kServer] = server_compressed_socket_.get();
+  }
 
   full_duplex_ = true;
   next_state_ = STATE_NONE;
   return OK;
 }
 
+void NaiveConnection::StartHedgeConnect() {
+  DCHECK(hedge_network_isolation_key_);
+  DCHECK_EQ(next_state_, STATE_CONNECT_SERVER_COMPLETE);
+
+  LOG(INFO) << "Connection " << id_ << " hedging connect to "
+            << origin_.ToString();
+
+  hedge_socket_handle_ = std::make_unique<ClientSocketHandle>();
+  hedge_pending_ = true;
+  int rv = InitSocketHandleForRawConnect2(
+      origin_, session_, LOAD_IGNORE_LIMITS, priority_, proxy_info_,
+      server_ssl_config_, proxy_ssl_config_, PRIVACY_MODE_DISABLED,
+      *hedge_network_isolation_key_, net_log_, hedge_socket_handle_.get(),
+      base::BindOnce(&NaiveConnection::OnHedgeConnectComplete,
+                     weak_ptr_factory_.GetWeakPtr()));
+  if (rv != ERR_IO_PENDING)
+    OnHedgeConnectComplete(rv);
+}
+
+void NaiveConnection::OnHedgeConnectComplete(int result) {
+  DCHECK(hedge_pending_);
+  hedge_pending_ = false;
+
+  if (result < 0) {
+    hedge_socket_handle_.reset();
+    // The original connect is still pending unless it has already failed.
+    if (primary_connect_result_ != ERR_IO_PENDING)
+      OnIOComplete(primary_connect_result_);
+    return;
+  }
+
+  // The hedged connect won. Destroying the original handle cancels its
+  // pending request.
+  tunnel_stream_request_.reset();
+  server_socket_handle_ = std::move(hedge_socket_handle_);
+  OnIOComplete(result);
+}
+
+void NaiveConnection::OnConnectTimeout() {
+  LOG(INFO) << "Connection " << id_ << " to " << origin_.ToString()
+            << " timed out";
+
+  hedge_timer_.Stop();
+  hedge_socket_handle_.reset();
+  hedge_pending_ = false;
+  // Cancels the pending request.
+  tunnel_stream_request_.reset();
+  server_socket_handle_ = std::make_unique<ClientSocketHandle>();
+  OnIOComplete(ERR_TIMED_OUT);
+}
+
+const StreamSocket* NaiveConnection::GetClientTransportSocket() const {
+  // Accepted sockets are TCPClientSocket.
+  if (protocol_ == ClientProtocol::kSocks5) {
+    return static_cast<const Socks5ServerSocket*>(client_socket_.get())
+        ->transport_socket();
+  } else if (protocol_ == ClientProtocol::kHttp) {
+    return static_cast<const HttpProxySocket*>(client_socket_.get())
+        ->transport_socket();
+  } else if (protocol_ == ClientProtocol::kRedir) {
+    return client_socket_.get();
+  }
+  return nullptr;
+}
+
+void NaiveConnection::MaybeSampleTcpInfo() {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  base::TimeTicks now = time_func_();
+  if (now < next_tcp_info_time_)
+    return;
+  next_tcp_info_time_ =
+      now + base::TimeDelta::FromSeconds(kTcpInfoSampleIntervalSeconds);
+
+  for (Direction side : {kClient, kServer}) {
+    if (tcp_fds_[side] < 0 || !sockets_[side])
+      continue;
+    uint32_t rtt_us;
+    TcpInfo& info = tcp_info_[side];
+    if (!GetTcpInfo(tcp_fds_[side], &rtt_us, &info.cwnd, &info.mss,
+                    &info.total_retrans)) {
+      continue;
+    }
+    info.rtt = base::TimeDelta::FromMicroseconds(rtt_us);
+
+    // Reads towards this leg need not exceed twice its congestion window.
+    Direction from = side == kClient ? kServer : kClient;
+    uint64_t window = uint64_t{info.cwnd} * info.mss;
+    if (window == 0) {
+      read_buffer_sizes_[from] = kBufferSize;
+    } else {
+      read_buffer_sizes_[from] = static_cast<int>(std::min<uint64_t>(
+          kBufferSize, std::max<uint64_t>(kMinBufferSize, window * 2)));
+    }
+  }
+#endif
+}
+
+std::string NaiveConnection::GetTcpInfoString() const {
+  std::string result;
+  for (Direction side : {kClient, kServer}) {
+    const TcpInfo& info = tcp_info_[side];
+    if (info.mss == 0)
+      continue;
+    base::StringAppendF(&result, "%s%s rtt=%dms cwnd=%u mss=%u retrans=%u",
+                        result.empty() ? "" : ", ",
+                        side == kClient ? "client" : "server",
+                        static_cast<int>(info.rtt.InMilliseconds()), info.cwnd,
+                        info.mss, info.total_retrans);
+  }
+  return result;
+}
+
+std::string NaiveConnection::GetPaddingString() const {
+  std::string result;
+  for (Direction side : {kClient, kServer}) {
+    if (num_paddings_[side] == 0)
+      continue;
+    base::StringAppendF(
+        &result, "%s%s padding frames=%d overhead=%lldB",
+        result.empty() ? "" : ", ", side == kClient ? "client" : "server",
+        num_paddings_[side],
+        static_cast<long long>(padding_bytes_[side] +
+                               num_paddings_[side] * kPaddingHeaderSize));
+  }
+  return result;
+}
+
 int NaiveConnection::Run(CompletionOnceCallback callback) {
   DCHECK(sockets_[kClient]);
   DCHECK(sockets_[kServer]);
@@ -308,16 +617,19 @@ void NaiveConnection::Pull(Direction from, Direction to) {
   if (errors_[kClient] < 0 || errors_[kServer] < 0)
     return;
 
-  int read_size = kBufferSize;
+  int buffer_size = read_buffer_sizes_[from];
+  int read_size = buffer_size;
   auto padding_direction = padding_detector_delegate_->GetPaddingDirection();
-  if (from == padding_direction && num_paddings_[from] < kFirstPaddings) {
+  if (from == padding_direction && ShouldPad(from)) {
     auto buffer = base::MakeRefCounted<GrowableIOBuffer>();
-    buffer->SetCapacity(kBufferSize);
+    buffer->SetCapacity(buffer_size);
     buffer->set_offset(kPaddingHeaderSize);
     read_buffers_[from] = buffer;
-    read_size = kBufferSize - kPaddingHeaderSize - kMaxPaddingSize;
+    // Leaves room for the largest padding the policy can pick.
+    read_size = buffer_size - kPaddingHeaderSize -
+                padding_detector_delegate_->GetPaddingPolicy().max_size;
   } else {
-    read_buffers_[from] = base::MakeRefCounted<IOBuffer>(kBufferSize);
+    read_buffers_[from] = base::MakeRefCounted<IOBuffer>(buffer_size);
   }
 
   DCHECK(sockets_[from]);
@@ -337,10 +649,14 @@ void NaiveConnection::Push(Direction from, Direction to, int size) {
   int write_size = size;
   int write_offset = 0;
   auto padding_direction = padding_detector_delegate_->GetPaddingDirection();
-  if (from == padding_direction && num_paddings_[from] < kFirstPaddings) {
+  if (from == padding_direction && ShouldPad(from)) {
     // Adds padding.
+    int padding_size =
+        padding_detector_delegate_->GetPaddingPolicy().PickPaddingSize(
+            padding_bytes_[from]);
     ++num_paddings_[from];
-    int padding_size = base::RandInt(0, kMaxPaddingSize);
+    padding_bytes_[from] += padding_size;
+    payload_bytes_[from] += size;
     auto* buffer = static_cast<GrowableIOBuffer*>(read_buffers_[from].get());
     buffer->set_offset(0);
     uint8_t* p = reinterpret_cast<uint8_t*>(buffer->data());
@@ -349,7 +665,9 @@ void NaiveConnection::Push(Direction from, Direction to, int size) {
     p[2] = padding_size;
     std::memset(p + kPaddingHeaderSize + size, 0, padding_size);
     write_size = kPaddingHeaderSize + size + padding_size;
-  } else if (to == padding_direction && num_paddings_[from] < kFirstPaddings) {
+  } else if (to == padding_direction &&
+             (ShouldPad(from) ||
+              read_padding_state_ != STATE_READ_PAYLOAD_LENGTH_1)) {
     // Removes padding.
     const char* p = read_buffers_[from]->data();
     bool trivial_padding = false;
@@ -362,6 +680,8 @@ void NaiveConnection::Push(Direction from, Direction to, int size) {
         write_size = payload_size;
         write_offset = kPaddingHeaderSize;
         ++num_paddings_[from];
+        padding_bytes_[from] += padding_size;
+        payload_bytes_[from] += payload_size;
         trivial_padding = true;
       }
     }
@@ -369,8 +689,8 @@ void NaiveConnection::Push(Direction from, Direction to, int size) {
       auto unpadded_buffer = base::MakeRefCounted<IOBuffer>(kBufferSize);
       char* unpadded_ptr = unpadded_buffer->data();
       for (int i = 0; i < size;) {
-        if (num_paddings_[from] >= kFirstPaddings &&
-            read_padding_state_ == STATE_READ_PAYLOAD_LENGTH_1) {
+        if (read_padding_state_ == STATE_READ_PAYLOAD_LENGTH_1 &&
+            !ShouldPad(from)) {
           std::memcpy(unpadded_ptr, p + i, size - i);
           unpadded_ptr += size - i;
           break;
@@ -391,6 +711,10 @@ void NaiveConnection::Push(Direction from, Direction to, int size) {
           case STATE_READ_PADDING_LENGTH:
             padding_length_ = static_cast<uint8_t>(p[i]);
             ++i;
+            // Counts the whole frame already. The policy is only checked
+            // between frames, where both ends have the same counts.
+            padding_bytes_[from] += padding_length_;
+            payload_bytes_[from] += payload_length_;
             read_padding_state_ = STATE_READ_PAYLOAD;
             break;
           case STATE_READ_PAYLOAD:
@@ -444,6 +768,11 @@ void NaiveConnection::Push(Direction from, Direction to, int size) {
     OnPushComplete(from, to, rv);
 }
 
+bool NaiveConnection::ShouldPad(Direction from) {
+  return padding_detector_delegate_->GetPaddingPolicy().ShouldPad(
+      num_paddings_[from], padding_bytes_[from], payload_bytes_[from]);
+}
+
 void NaiveConnection::Disconnect(Direction side) {
   if (sockets_[side]) {
     sockets_[side]->Disconnect();
@@ -516,6 +845,8 @@ void NaiveConnection::OnPullComplete(Direction from, Direction to, int result) {
 void NaiveConnection::OnPushComplete(Direction from, Direction to, int result) {
   if (result >= 0 && write_buffers_[to] != nullptr) {
     bytes_passed_without_yielding_[from] += result;
+    if (rate_limiter_)
+      rate_limiter_->Consume(result, time_func_());
     write_buffers_[to]->DidConsume(result);
     int size = write_buffers_[to]->BytesRemaining();
     if (size > 0) {
@@ -530,10 +861,28 @@ void NaiveConnection::OnPushComplete(Direction from, Direction to, int result) {
     }
   }
 
+  if (result > 0)
+    last_activity_time_ = time_func_();
+
   write_pending_[to] = false;
   // Checks for termination even if result is OK.
   OnPushError(from, to, result >= 0 ? OK : result);
 
+  MaybeSampleTcpInfo();
+
+  if (rate_limiter_) {
+    base::TimeDelta delay = rate_limiter_->GetDelay(time_func_());
+    if (!delay.is_zero()) {
+      bytes_passed_without_yielding_[from] = 0;
+      base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+          FROM_HERE,
+          base::BindOnce(&NaiveConnection::Pull,
+                         weak_ptr_factory_.GetWeakPtr(), from, to),
+          delay);
+      return;
+    }
+  }
+
   if (bytes_passed_without_yielding_[from] > kYieldAfterBytesRead ||
       time_func_() > yield_after_time_[from]) {
     bytes_passed_without_yielding_[from] = 0;
@@ -6,6 +6,7 @@
 #ifndef NET_TOOLS_NAIVE_NAIVE_CONNECTION_H_
 #define NET_TOOLS_NAIVE_NAIVE_CONNECTION_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -13,14 +14,18 @@
 #include "base/memory/scoped_refptr.h"
 #include "base/memory/weak_ptr.h"
 #include "base/time/time.h"
+#include "base/timer/timer.h"
 #include "net/base/completion_once_callback.h"
 #include "net/base/completion_repeating_callback.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/request_priority.h"
 #include "net/tools/naive/naive_protocol.h"
 #include "net/tools/naive/naive_proxy_delegate.h"
 
 namespace net {
 
 class ClientSocketHandle;
+class CompressedSocket;
 class DrainableIOBuffer;
 class HttpNetworkSession;
 class IOBuffer;
@@ -31,6 +36,8 @@ struct NetworkTrafficAnnotationTag;
 struct SSLConfig;
 class RedirectResolver;
 class NetworkIsolationKey;
+class TokenBucket;
+class TunnelStreamRequest;
 
 class NaiveConnection {
  public:
@@ -46,12 +53,32 @@ class NaiveConnection {
       RedirectResolver* resolver,
       HttpNetworkSession* session,
       const NetworkIsolationKey& network_isolation_key,
+      const NetworkIsolationKey* hedge_network_isolation_key,
+      base::TimeDelta hedge_delay,
+      base::TimeDelta connect_timeout,
+      RequestPriority priority,
+      TokenBucket* rate_limiter,
       const NetLogWithSource& net_log,
       std::unique_ptr<StreamSocket> accepted_socket,
       const NetworkTrafficAnnotationTag& traffic_annotation);
   ~NaiveConnection();
 
   unsigned int id() const { return id_; }
+  // The server the client asked for. Empty until the client connect is done.
+  const HostPortPair& origin() const { return origin_; }
+  // Time from the start of the server connect to its completion. Zero if the
+  // server connect has not completed successfully.
+  base::TimeDelta connect_server_duration() const {
+    return connect_server_duration_;
+  }
+  // Time of the creation of the connection or the last relayed data.
+  base::TimeTicks last_activity_time() const { return last_activity_time_; }
+  // Summarizes the latest TCP_INFO samples of both legs for logging. Empty if
+  // none was taken.
+  std::string GetTcpInfoString() const;
+  // Summarizes the padding frames of both directions for logging. Empty if
+  // nothing was padded.
+  std::string GetPaddingString() const;
   int Connect(CompletionOnceCallback callback);
   void Disconnect();
   int Run(CompletionOnceCallback callback);
@@ -65,6 +92,15 @@ class NaiveConnection {
     STATE_NONE,
   };
 
+  // Subset of TCP_INFO sampled on a TCP leg of the tunnel.
+  struct TcpInfo {
+    base::TimeDelta rtt;
+    // Congestion window in segments of |mss| bytes.
+    uint32_t cwnd = 0;
+    uint32_t mss = 0;
+    uint32_t total_retrans = 0;
+  };
+
   enum PaddingState {
     STATE_READ_PAYLOAD_LENGTH_1,
     STATE_READ_PAYLOAD_LENGTH_2,
@@ -78,10 +114,22 @@ class NaiveConnection {
   int DoLoop(int last_io_result);
   int DoConnectClient();
   int DoConnectClientComplete(int result);
+  void StartEarlyConnect();
+  void OnEarlyConnectComplete(int result);
+  // Sets |origin_| from the client handshake or the original destination.
+  int DetermineOrigin();
+  int StartServerConnect(CompletionOnceCallback callback);
   int DoConnectServer();
   int DoConnectServerComplete(int result);
+  void StartHedgeConnect();
+  void OnHedgeConnectComplete(int result);
+  void OnConnectTimeout();
+  const StreamSocket* GetClientTransportSocket() const;
+  void MaybeSampleTcpInfo();
   void Pull(Direction from, Direction to);
   void Push(Direction from, Direction to, int size);
+  // Whether the next frame read from |from| is padded.
+  bool ShouldPad(Direction from);
   void Disconnect(Direction side);
   bool IsConnected(Direction side);
   void OnBothDisconnected();
@@ -99,6 +147,13 @@ class NaiveConnection {
   RedirectResolver* resolver_;
   HttpNetworkSession* session_;
   const NetworkIsolationKey& network_isolation_key_;
+  // Null if hedged connects are disabled.
+  const NetworkIsolationKey* hedge_network_isolation_key_;
+  base::TimeDelta hedge_delay_;
+  base::TimeDelta connect_timeout_;
+  RequestPriority priority_;
+  // Shared by the connections of a listener. Null if unlimited.
+  TokenBucket* rate_limiter_;
   const NetLogWithSource& net_log_;
 
   CompletionRepeatingCallback io_callback_;
@@ -109,6 +164,29 @@ class NaiveConnection {
 
   std::unique_ptr<StreamSocket> client_socket_;
   std::unique_ptr<ClientSocketHandle> server_socket_handle_;
+  // Set while the server connect goes directly to a proxy session stream.
+  // Declared after the handle it fills in.
+  std::unique_ptr<TunnelStreamRequest> tunnel_stream_request_;
+  // Wraps the server socket if the proxy accepted compression. Declared after
+  // the handle that owns its transport.
+  std::unique_ptr<CompressedSocket> server_compressed_socket_;
+
+  HostPortPair origin_;
+  base::TimeTicks connect_server_start_time_;
+  base::TimeDelta connect_server_duration_;
+  base::OneShotTimer connect_timer_;
+  base::OneShotTimer hedge_timer_;
+  std::unique_ptr<ClientSocketHandle> hedge_socket_handle_;
+  bool hedge_pending_;
+  // The result of the original connect if it failed while the hedged connect
+  // was still pending.
+  int primary_connect_result_;
+  // Set if the server connect was started as soon as the client sent its
+  // request, before the client handshake completed.
+  bool early_connect_started_;
+  // The result of the early connect, or ERR_IO_PENDING while it is in
+  // progress.
+  int early_connect_result_;
 
   StreamSocket* sockets_[kNumDirections];
   scoped_refptr<IOBuffer> read_buffers_[kNumDirections];
@@ -118,11 +196,23 @@ class NaiveConnection {
   int bytes_passed_without_yielding_[kNumDirections];
   base::TimeTicks yield_after_time_[kNumDirections];
 
+  // Socket descriptors of the TCP legs, or -1 if a leg is not a plain TCP
+  // socket or TCP_INFO is unavailable.
+  int tcp_fds_[kNumDirections];
+  TcpInfo tcp_info_[kNumDirections];
+  base::TimeTicks next_tcp_info_time_;
+  // Sized after the window of the leg being written to.
+  int read_buffer_sizes_[kNumDirections];
+
   bool early_pull_pending_;
   bool can_push_to_server_;
   int early_pull_result_;
 
+  // Frames, padding bytes and payload bytes padded in each direction, indexed
+  // by the side the data is read from.
   int num_paddings_[kNumDirections];
+  int64_t padding_bytes_[kNumDirections];
+  int64_t payload_bytes_[kNumDirections];
   PaddingState read_padding_state_;
   int payload_length_;
   int padding_length_;
@@ -130,6 +220,7 @@ class NaiveConnection {
   bool full_duplex_;
 
   TimeFunc time_func_;
+  base::TimeTicks last_activity_time_;
 
   // Traffic annotation for socket control.
   const NetworkTrafficAnnotationTag& traffic_annotation_;
@@ -12,6 +12,7 @@
 #include "base/location.h"
 #include "base/logging.h"
 #include "base/threading/thread_task_runner_handle.h"
+#include "net/base/ip_endpoint.h"
 #include "net/base/load_flags.h"
 #include "net/base/net_errors.h"
 #include "net/http/http_network_session.h"
@@ -21,17 +22,40 @@
 #include "net/socket/client_socket_pool_manager.h"
 #include "net/socket/server_socket.h"
 #include "net/socket/stream_socket.h"
+#include "net/tools/naive/accept_limiter.h"
 #include "net/tools/naive/http_proxy_socket.h"
 #include "net/tools/naive/naive_proxy_delegate.h"
+#include "net/tools/naive/prewarmer.h"
 #include "net/tools/naive/socks5_server_socket.h"
+#include "net/tools/naive/token_bucket.h"
 
 namespace net {
 
+namespace {
+// Number of recent server connect latencies used to derive the hedge delay.
+constexpr size_t kMaxConnectLatencySamples = 100;
+// Uses the default hedge delay until there are this many samples.
+constexpr size_t kMinConnectLatencySamples = 20;
+constexpr int kDefaultHedgeDelayMs = 1000;
+constexpr int kMinHedgeDelayMs = 50;
+constexpr int kRejectedLogIntervalSeconds = 10;
+constexpr size_t kIdleWheelSlots = 64;
+}  // namespace
+
 NaiveProxy::NaiveProxy(std::unique_ptr<ServerSocket> listen_socket,
                        ClientProtocol protocol,
                        const std::string& listen_user,
                        const std::string& listen_pass,
                        int concurrency,
+                       base::TimeDelta connect_timeout,
+                       base::TimeDelta idle_timeout,
+                       bool hedge_connect,
+                       RequestPriority priority,
+                       int64_t max_rate,
+                       int accept_rate,
+                       int accept_rate_per_address,
+                       size_t prewarm_origins,
+                       bool prewarm_connect,
                        RedirectResolver* resolver,
                        HttpNetworkSession* session,
                        const NetworkTrafficAnnotationTag& traffic_annotation)
@@ -40,11 +64,19 @@ NaiveProxy::NaiveProxy(std::unique_ptr<ServerSocket> listen_socket,
       listen_user_(listen_user),
       listen_pass_(listen_pass),
       concurrency_(std::min(4, std::max(1, concurrency))),
+      connect_timeout_(connect_timeout),
+      idle_timeout_(idle_timeout),
+      hedge_connect_(hedge_connect),
+      priority_(priority),
+      rejected_accepts_(0),
       resolver_(resolver),
       session_(session),
       net_log_(
           NetLogWithSource::Make(session->net_log(), NetLogSourceType::NONE)),
       last_id_(0),
+      hedge_delay_(base::TimeDelta::FromMilliseconds(kDefaultHedgeDelayMs)),
+      next_connect_latency_(0),
+      idle_wheel_position_(0),
       traffic_annotation_(traffic_annotation) {
   const auto& proxy_config = static_cast<ConfiguredProxyResolutionService*>(
                                  session_->proxy_resolution_service())
@@ -63,6 +95,35 @@ NaiveProxy::NaiveProxy(std::unique_ptr<ServerSocket> listen_socket,
   for (int i = 0; i < concurrency_; i++) {
     network_isolation_keys_.push_back(NetworkIsolationKey::CreateTransient());
   }
+  if (hedge_connect_) {
+    hedge_network_isolation_key_ = NetworkIsolationKey::CreateTransient();
+  }
+
+  if (max_rate > 0) {
+    // Allows bursts of one second worth of traffic.
+    rate_limiter_ = std::make_unique<TokenBucket>(max_rate, max_rate,
+                                                  base::TimeTicks::Now());
+  }
+
+  if (accept_rate > 0 || accept_rate_per_address > 0) {
+    accept_limiter_ = std::make_unique<AcceptLimiter>(
+        accept_rate, accept_rate_per_address, base::TimeTicks::Now());
+  }
+
+  // Through a proxy, the origins are resolved and connected to by the server.
+  if (prewarm_origins > 0 && proxy_info_.is_direct()) {
+    prewarmer_ = std::make_unique<Prewarmer>(
+        prewarm_origins, prewarm_connect, proxy_info_, server_ssl_config_,
+        proxy_ssl_config_, network_isolation_keys_, session_, net_log_);
+  }
+
+  if (!idle_timeout_.is_zero()) {
+    idle_wheel_.resize(kIdleWheelSlots);
+    idle_slot_duration_ = idle_timeout_ / kIdleWheelSlots;
+    idle_timer_.Start(FROM_HERE, idle_slot_duration_,
+                      base::BindRepeating(&NaiveProxy::OnIdleTimer,
+                                          weak_ptr_factory_.GetWeakPtr()));
+  }
 
   DCHECK(listen_socket_);
   // Start accepting connections in next run loop in case when delegate is not
@@ -97,6 +158,24 @@ void NaiveProxy::HandleAcceptResult(int result) {
     LOG(ERROR) << "Accept error: rv=" << result;
     return;
   }
+  if (accept_limiter_) {
+    // Drops excess connections before anything is allocated for them.
+    base::TimeTicks now = base::TimeTicks::Now();
+    IPEndPoint peer_address;
+    if (accepted_socket_->GetPeerAddress(&peer_address) != OK ||
+        !accept_limiter_->TryAccept(peer_address.address(), now)) {
+      accepted_socket_.reset();
+      ++rejected_accepts_;
+      if (now - last_rejected_log_time_ >=
+          base::TimeDelta::FromSeconds(kRejectedLogIntervalSeconds)) {
+        LOG(INFO) << "Rejected " << rejected_accepts_
+                  << " connections over the accept rate";
+        rejected_accepts_ = 0;
+        last_rejected_log_time_ = now;
+      }
+      return;
+    }
+  }
   DoConnect();
 }
 
@@ -128,10 +207,14 @@ void NaiveProxy::DoConnect() {
   const auto& nik = network_isolation_keys_[last_id_ % concurrency_];
   auto connection_ptr = std::make_unique<NaiveConnection>(
       last_id_, protocol_, std::move(padding_detector_delegate), proxy_info_,
-      server_ssl_config_, proxy_ssl_config_, resolver_, session_, nik, net_log_,
+      server_ssl_config_, proxy_ssl_config_, resolver_, session_, nik,
+      hedge_connect_ ? &hedge_network_isolation_key_ : nullptr, hedge_delay_,
+      connect_timeout_, priority_, rate_limiter_.get(), net_log_,
       std::move(socket), traffic_annotation_);
   auto* connection = connection_ptr.get();
   connection_by_id_[connection->id()] = std::move(connection_ptr);
+  if (!idle_timeout_.is_zero())
+    ScheduleIdleCheck(connection->id(), idle_timeout_);
   int result = connection->Connect(
       base::BindRepeating(&NaiveProxy::OnConnectComplete,
                           weak_ptr_factory_.GetWeakPtr(), connection->id()));
@@ -152,6 +235,12 @@ void NaiveProxy::HandleConnectResult(NaiveConnection* connection, int result) {
     Close(connection->id(), result);
     return;
   }
+  if (hedge_connect_) {
+    RecordConnectLatency(connection->connect_server_duration());
+  }
+  if (prewarmer_) {
+    prewarmer_->RecordConnect(connection->origin());
+  }
   DoRun(connection);
 }
 
@@ -180,8 +269,12 @@ void NaiveProxy::Close(unsigned int connection_id, int reason) {
   if (it == connection_by_id_.end())
     return;
 
+  std::string tcp_info = it->second->GetTcpInfoString();
+  std::string padding = it->second->GetPaddingString();
   LOG(INFO) << "Connection " << connection_id
-            << " closed: " << ErrorToShortString(reason);
+            << " closed: " << ErrorToShortString(reason)
+            << (tcp_info.empty() ? "" : ", ") << tcp_info
+            << (padding.empty() ? "" : ", ") << padding;
 
   // The call stack might have callbacks which still have the pointer of
   // connection. Instead of referencing connection with ID all the time,
@@ -192,6 +285,54 @@ void NaiveProxy::Close(unsigned int connection_id, int reason) {
   connection_by_id_.erase(it);
 }
 
+void NaiveProxy::ScheduleIdleCheck(unsigned int connection_id,
+                                   base::TimeDelta delay) {
+  // Rounds up, but never into the current slot, which would be a full turn.
+  size_t slots = static_cast<size_t>(delay.IntDiv(idle_slot_duration_)) + 1;
+  slots = std::min(slots, kIdleWheelSlots - 1);
+  idle_wheel_[(idle_wheel_position_ + slots) % kIdleWheelSlots].push_back(
+      connection_id);
+}
+
+void NaiveProxy::OnIdleTimer() {
+  idle_wheel_position_ = (idle_wheel_position_ + 1) % kIdleWheelSlots;
+  std::vector<unsigned int> connection_ids;
+  connection_ids.swap(idle_wheel_[idle_wheel_position_]);
+
+  base::TimeTicks now = base::TimeTicks::Now();
+  for (unsigned int connection_id : connection_ids) {
+    auto* connection = FindConnection(connection_id);
+    if (!connection)
+      continue;
+    base::TimeDelta idle = now - connection->last_activity_time();
+    if (idle >= idle_timeout_) {
+      LOG(INFO) << "Connection " << connection_id << " idle for "
+                << idle.InSeconds() << " s";
+      Close(connection_id, ERR_TIMED_OUT);
+    } else {
+      ScheduleIdleCheck(connection_id, idle_timeout_ - idle);
+    }
+  }
+}
+
+void NaiveProxy::RecordConnectLatency(base::TimeDelta latency) {
+  if (connect_latencies_.size() < kMaxConnectLatencySamples) {
+    connect_latencies_.push_back(latency);
+  } else {
+    connect_latencies_[next_connect_latency_] = latency;
+    next_connect_latency_ =
+        (next_connect_latency_ + 1) % kMaxConnectLatencySamples;
+  }
+  if (connect_latencies_.size() < kMinConnectLatencySamples)
+    return;
+
+  std::vector<base::TimeDelta> sorted = connect_latencies_;
+  auto p95 = sorted.begin() + sorted.size() * 95 / 100;
+  std::nth_element(sorted.begin(), p95, sorted.end());
+  hedge_delay_ =
+      std::max(*p95, base::TimeDelta::FromMilliseconds(kMinHedgeDelayMs));
+}
+
 NaiveConnection* NaiveProxy::FindConnection(unsigned int connection_id) {
   auto it = connection_by_id_.find(connection_id);
   if (it == connection_by_id_.end())
@@ -6,14 +6,18 @@
 #ifndef NET_TOOLS_NAIVE_NAIVE_PROXY_H_
 #define NET_TOOLS_NAIVE_NAIVE_PROXY_H_
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <vector>
 
 #include "base/macros.h"
 #include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
 #include "net/base/completion_repeating_callback.h"
 #include "net/base/network_isolation_key.h"
+#include "net/base/request_priority.h"
 #include "net/log/net_log_with_source.h"
 #include "net/proxy_resolution/proxy_info.h"
 #include "net/ssl/ssl_config.h"
@@ -22,13 +26,16 @@
 
 namespace net {
 
+class AcceptLimiter;
 class ClientSocketHandle;
 class HttpNetworkSession;
 class NaiveConnection;
+class Prewarmer;
 class ServerSocket;
 class StreamSocket;
 struct NetworkTrafficAnnotationTag;
 class RedirectResolver;
+class TokenBucket;
 
 class NaiveProxy {
  public:
@@ -37,6 +44,15 @@ class NaiveProxy {
              const std::string& listen_user,
              const std::string& listen_pass,
              int concurrency,
+             base::TimeDelta connect_timeout,
+             base::TimeDelta idle_timeout,
+             bool hedge_connect,
+             RequestPriority priority,
+             int64_t max_rate,
+             int accept_rate,
+             int accept_rate_per_address,
+             size_t prewarm_origins,
+             bool prewarm_connect,
              RedirectResolver* resolver,
              HttpNetworkSession* session,
              const NetworkTrafficAnnotationTag& traffic_annotation);
@@ -57,6 +73,14 @@ class NaiveProxy {
 
   void Close(unsigned int connection_id, int reason);
 
+  // Checks the connection for idleness when |delay| has passed.
+  void ScheduleIdleCheck(unsigned int connection_id, base::TimeDelta delay);
+  void OnIdleTimer();
+
+  // Records the server connect latency of a successful connection and updates
+  // the hedge delay to the 95th percentile of recent latencies.
+  void RecordConnectLatency(base::TimeDelta latency);
+
   NaiveConnection* FindConnection(unsigned int connection_id);
 
   std::unique_ptr<ServerSocket> listen_socket_;
@@ -64,6 +88,19 @@ class NaiveProxy {
   std::string listen_user_;
   std::string listen_pass_;
   int concurrency_;
+  base::TimeDelta connect_timeout_;
+  // Zero if tunnels never time out when idle.
+  base::TimeDelta idle_timeout_;
+  bool hedge_connect_;
+  RequestPriority priority_;
+  // Limits the relayed bytes per second of all connections. Null if
+  // unlimited.
+  std::unique_ptr<TokenBucket> rate_limiter_;
+  // Null if accepts are not limited.
+  std::unique_ptr<AcceptLimiter> accept_limiter_;
+  // Connections rejected by |accept_limiter_| since they were last logged.
+  int rejected_accepts_;
+  base::TimeTicks last_rejected_log_time_;
   ProxyInfo proxy_info_;
   SSLConfig server_ssl_config_;
   SSLConfig proxy_ssl_config_;
@@ -77,8 +114,26 @@ class NaiveProxy {
 
   std::vector<NetworkIsolationKey> network_isolation_keys_;
 
+  // Used by hedged connects to reach the upstream through another session.
+  NetworkIsolationKey hedge_network_isolation_key_;
+  base::TimeDelta hedge_delay_;
+  std::vector<base::TimeDelta> connect_latencies_;
+  size_t next_connect_latency_;
+
+  // Warms up hot origins in direct mode. Null if disabled.
+  std::unique_ptr<Prewarmer> prewarmer_;
+
   std::map<unsigned int, std::unique_ptr<NaiveConnection>> connection_by_id_;
 
+  // Timing wheel of connection IDs spanning one idle timeout. Activity does
+  // not touch the wheel; a connection is checked when its slot comes up and
+  // is then either closed or moved to the slot of its new deadline. IDs of
+  // closed connections are dropped at that point.
+  std::vector<std::vector<unsigned int>> idle_wheel_;
+  size_t idle_wheel_position_;
+  base::TimeDelta idle_slot_duration_;
+  base::RepeatingTimer idle_timer_;
+
   const NetworkTrafficAnnotationTag& traffic_annotation_;
 
   base::WeakPtrFactory<NaiveProxy> weak_ptr_factory_{this};
@@ -3,36 +3,52 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
 #include <limits>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "base/at_exit.h"
+#include "base/bind.h"
 #include "base/command_line.h"
 #include "base/feature_list.h"
 #include "base/files/file_path.h"
+#include "base/files/file_util.h"
 #include "base/json/json_file_value_serializer.h"
 #include "base/json/json_writer.h"
 #include "base/logging.h"
 #include "base/macros.h"
+#include "base/process/process_metrics.h"
 #include "base/rand_util.h"
 #include "base/run_loop.h"
 #include "base/strings/escape.h"
 #include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/system/sys_info.h"
 #include "base/task/single_thread_task_executor.h"
+#include "base/task/thread_pool.h"
 #include "base/task/thread_pool/thread_pool_instance.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/time/time.h"
 #include "base/values.h"
 #include "build/build_config.h"
 #include "components/version_info/version_info.h"
 #include "net/base/auth.h"
+#include "net/base/ip_address.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_errors.h"
+#include "net/base/network_change_notifier.h"
 #include "net/base/network_isolation_key.h"
+#include "net/base/request_priority.h"
 #include "net/base/url_util.h"
 #include "net/cert/cert_verifier.h"
+#include "net/cert/internal/system_trust_store.h"
 #include "net/cert_net/cert_net_fetcher_url_request.h"
 #include "net/dns/host_resolver.h"
 #include "net/dns/mapped_host_resolver.h"
@@ -51,21 +67,27 @@
 #include "net/proxy_resolution/proxy_config.h"
 #include "net/proxy_resolution/proxy_config_service_fixed.h"
 #include "net/proxy_resolution/proxy_config_with_annotation.h"
+#include "net/quic/quic_context.h"
 #include "net/socket/client_socket_pool_manager.h"
 #include "net/socket/ssl_client_socket.h"
 #include "net/socket/tcp_server_socket.h"
+#include "net/socket/tcp_socket.h"
 #include "net/socket/udp_server_socket.h"
 #include "net/ssl/ssl_key_logger_impl.h"
 #include "net/third_party/quiche/src/quic/core/quic_versions.h"
+#include "net/third_party/quiche/src/spdy/core/spdy_protocol.h"
+#include "net/tools/naive/async_log_sink.h"
 #include "net/tools/naive/naive_protocol.h"
 #include "net/tools/naive/naive_proxy.h"
 #include "net/tools/naive/naive_proxy_delegate.h"
+#include "net/tools/naive/padding_policy.h"
 #include "net/tools/naive/redirect_resolver.h"
 #include "net/traffic_annotation/network_traffic_annotation.h"
 #include "net/url_request/url_request_context.h"
 #include "net/url_request/url_request_context_builder.h"
 #include "url/gurl.h"
 #include "url/scheme_host_port.h"
+#include "url/url_constants.h"
 #include "url/url_util.h"
 
 #if defined(OS_MACOSX)
@@ -78,39 +100,114 @@ constexpr int kListenBackLog = 512;
 constexpr int kDefaultMaxSocketsPerPool = 256;
 constexpr int kDefaultMaxSocketsPerGroup = 255;
 constexpr int kExpectedMaxUsers = 8;
+// Keeps the shared HTTP/2 session window from stalling sessions with many
+// tunnels.
+constexpr size_t kSpdySessionRecvWindowPerTunnel = 256 * 1024;
+// How long the system DNS config may take to reach the built-in DNS client.
+constexpr int kDnsConfigTimeoutSeconds = 5;
 constexpr net::NetworkTrafficAnnotationTag kTrafficAnnotation =
     net::DefineNetworkTrafficAnnotation("naive", "");
 
 struct CommandLine {
-  std::string listen;
+  std::vector<std::string> listen;
   std::string proxy;
   std::string concurrency;
   std::string extra_headers;
+  bool compression;
+  std::string padding_policy;
   std::string host_resolver_rules;
+  base::FilePath host_resolver_rules_file;
   std::string resolver_range;
+  std::string resolver_doh;
+  std::string health_check_interval;
+  std::string http2_settings;
+  std::string connect_timeout;
+  std::string idle_timeout;
+  bool hedge_connect;
+  std::string prewarm;
+  bool prewarm_connect;
+  bool async_dns;
   bool no_log;
   base::FilePath log;
+  std::string log_max_size;
   base::FilePath log_net_log;
   base::FilePath ssl_key_log_file;
+  bool startup_trace;
 };
 
-struct Params {
+struct ListenParams {
   net::ClientProtocol protocol;
   std::string listen_user;
   std::string listen_pass;
   std::string listen_addr;
   int listen_port;
+  net::RequestPriority priority;
+  int64_t max_rate;
+  int accept_rate;
+  int accept_rate_per_ip;
+  int backlog;
+  bool reuse_port;
+};
+
+struct Params {
+  std::vector<ListenParams> listen;
   int concurrency;
   net::HttpRequestHeaders extra_headers;
+  bool compression;
+  net::PaddingPolicy padding_policy;
   std::string proxy_url;
   std::u16string proxy_user;
   std::u16string proxy_pass;
   std::string host_resolver_rules;
   net::IPAddress resolver_range;
   size_t resolver_prefix;
+  GURL resolver_doh_url;
+  base::TimeDelta health_check_interval;
+  spdy::SettingsMap http2_settings;
+  base::TimeDelta connect_timeout;
+  base::TimeDelta idle_timeout;
+  bool hedge_connect;
+  size_t prewarm_origins;
+  bool prewarm_connect;
+  bool async_dns;
   logging::LoggingSettings log_settings;
+  base::FilePath log_path;
+  int64_t log_max_size;
   base::FilePath net_log_path;
   base::FilePath ssl_key_path;
+  bool startup_trace;
+};
+
+// Measures the startup phases for --startup-trace.
+class StartupTrace {
+ public:
+  StartupTrace() : start_(base::TimeTicks::Now()), last_(start_) {}
+
+  // Ends the current phase.
+  void Mark(const char* phase) {
+    auto now = base::TimeTicks::Now();
+    phases_.emplace_back(phase, now - last_);
+    last_ = now;
+  }
+
+  void Report() const {
+    for (const auto& phase : phases_) {
+      std::cerr << "Startup " << phase.first << ": "
+                << phase.second.InMillisecondsF() << " ms" << std::endl;
+    }
+    std::cerr << "Startup total: " << (last_ - start_).InMillisecondsF()
+              << " ms" << std::endl;
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+    auto metrics = base::ProcessMetrics::CreateCurrentProcessMetrics();
+    std::cerr << "Startup RSS: " << metrics->GetResidentSetSize() / 1024
+              << " KiB" << std::endl;
+#endif
+  }
+
+ private:
+  const base::TimeTicks start_;
+  base::TimeTicks last_;
+  std::vector<std::pair<const char*, base::TimeDelta>> phases_;
 };
 
 std::unique_ptr<base::Value> GetConstants() {
@@ -132,18 +229,51 @@ void GetCommandLine(const base::CommandLine& proc, CommandLine* cmdline) {
                  "Options:\n"
                  "-h, --help                 Show this message\n"
                  "--version                  Print version\n"
-                 "--listen=<proto>://[addr][:port]\n"
+                 "--listen=<proto>://[addr][:port][?<query>]\n"
                  "                           proto: socks, http\n"
                  "                                  redir (Linux only)\n"
+                 "                           query: priority=<level>\n"
+                 "                                  max-rate=<bytes/s>\n"
+                 "                                  accept-rate=<N/s>\n"
+                 "                                  accept-rate-per-ip=<N/s>\n"
+                 "                                  backlog=<N>\n"
+                 "                                  reuse-port (Linux)\n"
                  "--proxy=<proto>://[<user>:<pass>@]<hostname>[:<port>]\n"
                  "                           proto: https, quic\n"
                  "--concurrency=<N>          Use N connections, less secure\n"
                  "--extra-headers=...        Extra headers split by CRLF\n"
+                 "--compression              Compress tunnels if the proxy\n"
+                 "                           supports it\n"
+                 "                           Leaks content through sizes,\n"
+                 "                           weakens padding\n"
+                 "--padding-policy=<key>=<value>,...\n"
+                 "                           Padding proposed to the proxy\n"
+                 "                           keys: frames, min, max, budget,\n"
+                 "                                 stop-after\n"
                  "--host-resolver-rules=...  Resolver rules\n"
+                 "--host-resolver-rules-file=<path>\n"
+                 "                           Resolver rules, one per line\n"
                  "--resolver-range=...       Redirect resolver range\n"
+                 "--resolver-doh=<url>       Forward other DNS queries to\n"
+                 "                           this DoH server via proxy\n"
+                 "--health-check-interval=<N>\n"
+                 "                           HTTP/2 PING after N s idle\n"
+                 "--http2-settings=<name>=<value>,...\n"
+                 "                           Local HTTP/2 SETTINGS\n"
+                 "--connect-timeout=<N>      Fail tunnel connects after N s\n"
+                 "--idle-timeout=<N>         Close tunnels idle for N s\n"
+                 "--hedge-connect            Race slow connects on another\n"
+                 "                           session\n"
+                 "--prewarm=<N>              Keep DNS of N hot origins fresh\n"
+                 "                           (direct only)\n"
+                 "--prewarm-connect          Also preconnect to them\n"
+                 "--async-dns                Use built-in DNS client with\n"
+                 "                           reused sockets\n"
                  "--log[=<path>]             Log to stderr, or file\n"
+                 "--log-max-size=<N>         Rotate log file over N MB\n"
                  "--log-net-log=<path>       Save NetLog\n"
                  "--ssl-key-log-file=<path>  Save SSL keys for Wireshark\n"
+                 "--startup-trace            Print startup phase times\n"
               << std::endl;
     exit(EXIT_SUCCESS);
   }
@@ -153,17 +283,36 @@ void GetCommandLine(const base::CommandLine& proc, CommandLine* cmdline) {
     exit(EXIT_SUCCESS);
   }
 
-  cmdline->listen = proc.GetSwitchValueASCII("listen");
+  std::string listen = proc.GetSwitchValueASCII("listen");
+  if (!listen.empty()) {
+    cmdline->listen.push_back(listen);
+  }
   cmdline->proxy = proc.GetSwitchValueASCII("proxy");
   cmdline->concurrency = proc.GetSwitchValueASCII("concurrency");
   cmdline->extra_headers = proc.GetSwitchValueASCII("extra-headers");
+  cmdline->compression = proc.HasSwitch("compression");
+  cmdline->padding_policy = proc.GetSwitchValueASCII("padding-policy");
   cmdline->host_resolver_rules =
       proc.GetSwitchValueASCII("host-resolver-rules");
+  cmdline->host_resolver_rules_file =
+      proc.GetSwitchValuePath("host-resolver-rules-file");
   cmdline->resolver_range = proc.GetSwitchValueASCII("resolver-range");
+  cmdline->resolver_doh = proc.GetSwitchValueASCII("resolver-doh");
+  cmdline->health_check_interval =
+      proc.GetSwitchValueASCII("health-check-interval");
+  cmdline->http2_settings = proc.GetSwitchValueASCII("http2-settings");
+  cmdline->connect_timeout = proc.GetSwitchValueASCII("connect-timeout");
+  cmdline->idle_timeout = proc.GetSwitchValueASCII("idle-timeout");
+  cmdline->hedge_connect = proc.HasSwitch("hedge-connect");
+  cmdline->prewarm = proc.GetSwitchValueASCII("prewarm");
+  cmdline->prewarm_connect = proc.HasSwitch("prewarm-connect");
+  cmdline->async_dns = proc.HasSwitch("async-dns");
   cmdline->no_log = !proc.HasSwitch("log");
   cmdline->log = proc.GetSwitchValuePath("log");
+  cmdline->log_max_size = proc.GetSwitchValueASCII("log-max-size");
   cmdline->log_net_log = proc.GetSwitchValuePath("log-net-log");
   cmdline->ssl_key_log_file = proc.GetSwitchValuePath("ssl-key-log-file");
+  cmdline->startup_trace = proc.HasSwitch("startup-trace");
 }
 
 void GetCommandLineFromConfig(const base::FilePath& config_path,
@@ -181,9 +330,17 @@ void GetCommandLineFromConfig(const base::FilePath& config_path,
     std::cerr << "Invalid config format" << std::endl;
     exit(EXIT_FAILURE);
   }
-  const auto* listen = value->FindStringKey("listen");
-  if (listen) {
-    cmdline->listen = *listen;
+  const auto* listen = value->FindKey("listen");
+  if (listen && listen->is_string()) {
+    cmdline->listen.push_back(listen->GetString());
+  } else if (listen && listen->is_list()) {
+    for (const auto& item : listen->GetList()) {
+      if (!item.is_string()) {
+        std::cerr << "Invalid listen in config" << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      cmdline->listen.push_back(item.GetString());
+    }
   }
   const auto* proxy = value->FindStringKey("proxy");
   if (proxy) {
@@ -197,20 +354,65 @@ void GetCommandLineFromConfig(const base::FilePath& config_path,
   if (extra_headers) {
     cmdline->extra_headers = *extra_headers;
   }
+  cmdline->compression = value->FindBoolKey("compression").value_or(false);
+  const auto* padding_policy = value->FindStringKey("padding-policy");
+  if (padding_policy) {
+    cmdline->padding_policy = *padding_policy;
+  }
   const auto* host_resolver_rules = value->FindStringKey("host-resolver-rules");
   if (host_resolver_rules) {
     cmdline->host_resolver_rules = *host_resolver_rules;
   }
+  const auto* host_resolver_rules_file =
+      value->FindStringKey("host-resolver-rules-file");
+  if (host_resolver_rules_file) {
+    cmdline->host_resolver_rules_file =
+        base::FilePath::FromUTF8Unsafe(*host_resolver_rules_file);
+  }
   const auto* resolver_range = value->FindStringKey("resolver-range");
   if (resolver_range) {
     cmdline->resolver_range = *resolver_range;
   }
+  const auto* resolver_doh = value->FindStringKey("resolver-doh");
+  if (resolver_doh) {
+    cmdline->resolver_doh = *resolver_doh;
+  }
+  const auto* health_check_interval =
+      value->FindStringKey("health-check-interval");
+  if (health_check_interval) {
+    cmdline->health_check_interval = *health_check_interval;
+  }
+  const auto* http2_settings = value->FindStringKey("http2-settings");
+  if (http2_settings) {
+    cmdline->http2_settings = *http2_settings;
+  }
+  const auto* connect_timeout = value->FindStringKey("connect-timeout");
+  if (connect_timeout) {
+    cmdline->connect_timeout = *connect_timeout;
+  }
+  const auto* idle_timeout = value->FindStringKey("idle-timeout");
+  if (idle_timeout) {
+    cmdline->idle_timeout = *idle_timeout;
+  }
+  cmdline->hedge_connect =
+      value->FindBoolKey("hedge-connect").value_or(false);
+  const auto* prewarm = value->FindStringKey("prewarm");
+  if (prewarm) {
+    cmdline->prewarm = *prewarm;
+  }
+  cmdline->prewarm_connect =
+      value->FindBoolKey("prewarm-connect").value_or(false);
+  cmdline->async_dns = value->FindBoolKey("async-dns").value_or(false);
   cmdline->no_log = true;
   const auto* log = value->FindStringKey("log");
   if (log) {
     cmdline->no_log = false;
     cmdline->log = base::FilePath::FromUTF8Unsafe(*log);
   }
+  const auto* log_max_size = value->FindStringKey("log-max-size");
+  if (log_max_size) {
+    cmdline->log_max_size = *log_max_size;
+  }
   const auto* log_net_log = value->FindStringKey("log-net-log");
   if (log_net_log) {
     cmdline->log_net_log = base::FilePath::FromUTF8Unsafe(*log_net_log);
@@ -220,6 +422,7 @@ void GetCommandLineFromConfig(const base::FilePath& config_path,
     cmdline->ssl_key_log_file =
         base::FilePath::FromUTF8Unsafe(*ssl_key_log_file);
   }
+  cmdline->startup_trace = value->FindBoolKey("startup-trace").value_or(false);
 }
 
 std::string GetProxyFromURL(const GURL& url) {
@@ -230,54 +433,188 @@ std::string GetProxyFromURL(const GURL& url) {
   return str;
 }
 
-bool ParseCommandLine(const CommandLine& cmdline, Params* params) {
+bool ParseHttp2SettingName(base::StringPiece name,
+                           spdy::SpdyKnownSettingsId* id) {
+  if (name == "header-table-size") {
+    *id = spdy::SETTINGS_HEADER_TABLE_SIZE;
+  } else if (name == "max-concurrent-streams") {
+    *id = spdy::SETTINGS_MAX_CONCURRENT_STREAMS;
+  } else if (name == "initial-window-size") {
+    *id = spdy::SETTINGS_INITIAL_WINDOW_SIZE;
+  } else if (name == "max-frame-size") {
+    *id = spdy::SETTINGS_MAX_FRAME_SIZE;
+  } else if (name == "max-header-list-size") {
+    *id = spdy::SETTINGS_MAX_HEADER_LIST_SIZE;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool ParseListen(const std::string& listen, ListenParams* params) {
   params->protocol = net::ClientProtocol::kSocks5;
   params->listen_addr = "0.0.0.0";
   params->listen_port = 1080;
-  url::AddStandardScheme("socks",
-                         url::SCHEME_WITH_HOST_PORT_AND_USER_INFORMATION);
-  url::AddStandardScheme("redir", url::SCHEME_WITH_HOST_AND_PORT);
-  if (!cmdline.listen.empty()) {
-    GURL url(cmdline.listen);
-    if (url.scheme() == "socks") {
-      params->protocol = net::ClientProtocol::kSocks5;
-      params->listen_port = 1080;
-    } else if (url.scheme() == "http") {
-      params->protocol = net::ClientProtocol::kHttp;
-      params->listen_port = 8080;
-    } else if (url.scheme() == "redir") {
+  params->priority = net::MAXIMUM_PRIORITY;
+  params->max_rate = 0;
+  params->accept_rate = 0;
+  params->accept_rate_per_ip = 0;
+  params->backlog = kListenBackLog;
+  params->reuse_port = false;
+  if (listen.empty())
+    return true;
+
+  GURL url(listen);
+  if (url.scheme() == "socks") {
+    params->protocol = net::ClientProtocol::kSocks5;
+    params->listen_port = 1080;
+  } else if (url.scheme() == "http") {
+    params->protocol = net::ClientProtocol::kHttp;
+    params->listen_port = 8080;
+  } else if (url.scheme() == "redir") {
 #if defined(OS_LINUX)
-      params->protocol = net::ClientProtocol::kRedir;
-      params->listen_port = 1080;
+    params->protocol = net::ClientProtocol::kRedir;
+    params->listen_port = 1080;
 #else
-      std::cerr << "Redir protocol only supports Linux." << std::endl;
-      return false;
+    std::cerr << "Redir protocol only supports Linux." << std::endl;
+    return false;
 #endif
+  } else {
+    std::cerr << "Invalid scheme in --listen" << std::endl;
+    return false;
+  }
+  if (!url.username().empty()) {
+    params->listen_user = base::UnescapeBinaryURLComponent(url.username());
+  }
+  if (!url.password().empty()) {
+    params->listen_pass = base::UnescapeBinaryURLComponent(url.password());
+  }
+  if (!url.host().empty()) {
+    params->listen_addr = url.host();
+  }
+  if (!url.port().empty()) {
+    if (!base::StringToInt(url.port(), &params->listen_port)) {
+      std::cerr << "Invalid port in --listen" << std::endl;
+      return false;
+    }
+    if (params->listen_port <= 0 ||
+        params->listen_port > std::numeric_limits<uint16_t>::max()) {
+      std::cerr << "Invalid port in --listen" << std::endl;
+      return false;
+    }
+  }
+
+  std::string priority;
+  if (net::GetValueForKeyInQuery(url, "priority", &priority)) {
+    if (priority == "highest") {
+      params->priority = net::HIGHEST;
+    } else if (priority == "medium") {
+      params->priority = net::MEDIUM;
+    } else if (priority == "low") {
+      params->priority = net::LOW;
+    } else if (priority == "lowest") {
+      params->priority = net::LOWEST;
+    } else if (priority == "idle") {
+      params->priority = net::IDLE;
     } else {
-      std::cerr << "Invalid scheme in --listen" << std::endl;
+      std::cerr << "Invalid priority in --listen" << std::endl;
       return false;
     }
-    if (!url.username().empty()) {
-      params->listen_user = base::UnescapeBinaryURLComponent(url.username());
+  }
+  std::string max_rate;
+  if (net::GetValueForKeyInQuery(url, "max-rate", &max_rate)) {
+    if (!base::StringToInt64(max_rate, &params->max_rate) ||
+        params->max_rate < 0) {
+      std::cerr << "Invalid max-rate in --listen" << std::endl;
+      return false;
     }
-    if (!url.password().empty()) {
-      params->listen_pass = base::UnescapeBinaryURLComponent(url.password());
+  }
+  std::string accept_rate;
+  if (net::GetValueForKeyInQuery(url, "accept-rate", &accept_rate)) {
+    if (!base::StringToInt(accept_rate, &params->accept_rate) ||
+        params->accept_rate < 0) {
+      std::cerr << "Invalid accept-rate in --listen" << std::endl;
+      return false;
     }
-    if (!url.host().empty()) {
-      params->listen_addr = url.host();
+  }
+  std::string accept_rate_per_ip;
+  if (net::GetValueForKeyInQuery(url, "accept-rate-per-ip",
+                                 &accept_rate_per_ip)) {
+    if (!base::StringToInt(accept_rate_per_ip, &params->accept_rate_per_ip) ||
+        params->accept_rate_per_ip < 0) {
+      std::cerr << "Invalid accept-rate-per-ip in --listen" << std::endl;
+      return false;
     }
-    if (!url.port().empty()) {
-      if (!base::StringToInt(url.port(), &params->listen_port)) {
-        std::cerr << "Invalid port in --listen" << std::endl;
-        return false;
-      }
-      if (params->listen_port <= 0 ||
-          params->listen_port > std::numeric_limits<uint16_t>::max()) {
-        std::cerr << "Invalid port in --listen" << std::endl;
-        return false;
-      }
+  }
+  std::string backlog;
+  if (net::GetValueForKeyInQuery(url, "backlog", &backlog)) {
+    if (!base::StringToInt(backlog, &params->backlog) ||
+        params->backlog <= 0) {
+      std::cerr << "Invalid backlog in --listen" << std::endl;
+      return false;
     }
   }
+  std::string reuse_port;
+  if (net::GetValueForKeyInQuery(url, "reuse-port", &reuse_port)) {
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+    params->reuse_port = true;
+#else
+    std::cerr << "reuse-port only supports Linux." << std::endl;
+    return false;
+#endif
+  }
+  return true;
+}
+
+// Same as TCPServerSocket::Listen() but optionally sets SO_REUSEPORT, so that
+// several naive processes can listen on one port with the kernel balancing
+// connections between them.
+int ListenTCP(const ListenParams& listen,
+              net::NetLog* net_log,
+              std::unique_ptr<net::TCPServerSocket>* server_socket) {
+  net::IPAddress address;
+  if (!address.AssignFromIPLiteral(listen.listen_addr))
+    return net::ERR_ADDRESS_INVALID;
+  net::IPEndPoint endpoint(address, listen.listen_port);
+
+  auto socket = std::make_unique<net::TCPSocket>(
+      /*socket_performance_watcher=*/nullptr, net_log, net::NetLogSource());
+  int result = socket->Open(endpoint.GetFamily());
+  if (result != net::OK)
+    return result;
+  result = socket->SetDefaultOptionsForServer();
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  if (result == net::OK && listen.reuse_port)
+    result = socket->AllowPortReuse();
+#endif
+  if (result == net::OK)
+    result = socket->Bind(endpoint);
+  if (result == net::OK)
+    result = socket->Listen(listen.backlog);
+  if (result != net::OK) {
+    socket->Close();
+    return result;
+  }
+  *server_socket = std::make_unique<net::TCPServerSocket>(std::move(socket));
+  return net::OK;
+}
+
+bool ParseCommandLine(const CommandLine& cmdline, Params* params) {
+  url::AddStandardScheme("socks",
+                         url::SCHEME_WITH_HOST_PORT_AND_USER_INFORMATION);
+  url::AddStandardScheme("redir", url::SCHEME_WITH_HOST_AND_PORT);
+  bool has_redir = false;
+  if (cmdline.listen.empty()) {
+    params->listen.emplace_back();
+    ParseListen("", &params->listen.back());
+  }
+  for (const auto& listen : cmdline.listen) {
+    params->listen.emplace_back();
+    if (!ParseListen(listen, &params->listen.back()))
+      return false;
+    if (params->listen.back().protocol == net::ClientProtocol::kRedir)
+      has_redir = true;
+  }
 
   params->proxy_url = "direct://";
   GURL url(cmdline.proxy);
@@ -305,10 +642,34 @@ bool ParseCommandLine(const CommandLine& cmdline, Params* params) {
   }
 
   params->extra_headers.AddHeadersFromString(cmdline.extra_headers);
+  params->compression = cmdline.compression;
+
+  if (!net::PaddingPolicy::Parse(cmdline.padding_policy,
+                                 &params->padding_policy)) {
+    std::cerr << "Invalid padding policy" << std::endl;
+    return false;
+  }
 
   params->host_resolver_rules = cmdline.host_resolver_rules;
+  if (!cmdline.host_resolver_rules_file.empty()) {
+    std::string rules;
+    if (!base::ReadFileToString(cmdline.host_resolver_rules_file, &rules)) {
+      std::cerr << "Invalid host resolver rules file" << std::endl;
+      return false;
+    }
+    // One rule per line. Lines starting with # are comments.
+    for (base::StringPiece line :
+         base::SplitStringPiece(rules, "\r\n", base::TRIM_WHITESPACE,
+                                base::SPLIT_WANT_NONEMPTY)) {
+      if (line[0] == '#')
+        continue;
+      if (!params->host_resolver_rules.empty())
+        params->host_resolver_rules += ',';
+      params->host_resolver_rules.append(line.data(), line.size());
+    }
+  }
 
-  if (params->protocol == net::ClientProtocol::kRedir) {
+  if (has_redir) {
     std::string range = "100.64.0.0/10";
     if (!cmdline.resolver_range.empty())
       range = cmdline.resolver_range;
@@ -322,12 +683,78 @@ bool ParseCommandLine(const CommandLine& cmdline, Params* params) {
       std::cerr << "IPv6 resolver range not supported" << std::endl;
       return false;
     }
+
+    if (!cmdline.resolver_doh.empty()) {
+      params->resolver_doh_url = GURL(cmdline.resolver_doh);
+      if (!params->resolver_doh_url.is_valid() ||
+          !params->resolver_doh_url.SchemeIs(url::kHttpsScheme)) {
+        std::cerr << "Invalid resolver DoH URL" << std::endl;
+        return false;
+      }
+    }
+  }
+
+  if (!cmdline.health_check_interval.empty()) {
+    int seconds;
+    if (!base::StringToInt(cmdline.health_check_interval, &seconds) ||
+        seconds < 0) {
+      std::cerr << "Invalid health check interval" << std::endl;
+      return false;
+    }
+    params->health_check_interval = base::TimeDelta::FromSeconds(seconds);
   }
 
+  for (const auto& setting : base::SplitStringPiece(
+           cmdline.http2_settings, ",", base::TRIM_WHITESPACE,
+           base::SPLIT_WANT_NONEMPTY)) {
+    std::vector<base::StringPiece> name_value = base::SplitStringPiece(
+        setting, "=", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL);
+    spdy::SpdyKnownSettingsId id;
+    uint32_t value;
+    if (name_value.size() != 2 || !ParseHttp2SettingName(name_value[0], &id) ||
+        !base::StringToUint(name_value[1], &value)) {
+      std::cerr << "Invalid HTTP/2 settings" << std::endl;
+      return false;
+    }
+    params->http2_settings[id] = value;
+  }
+
+  if (!cmdline.connect_timeout.empty()) {
+    int seconds;
+    if (!base::StringToInt(cmdline.connect_timeout, &seconds) || seconds < 0) {
+      std::cerr << "Invalid connect timeout" << std::endl;
+      return false;
+    }
+    params->connect_timeout = base::TimeDelta::FromSeconds(seconds);
+  }
+
+  if (!cmdline.idle_timeout.empty()) {
+    int seconds;
+    if (!base::StringToInt(cmdline.idle_timeout, &seconds) || seconds < 0) {
+      std::cerr << "Invalid idle timeout" << std::endl;
+      return false;
+    }
+    params->idle_timeout = base::TimeDelta::FromSeconds(seconds);
+  }
+
+  params->hedge_connect = cmdline.hedge_connect;
+
+  params->prewarm_origins = 0;
+  if (!cmdline.prewarm.empty()) {
+    if (!base::StringToSizeT(cmdline.prewarm, &params->prewarm_origins)) {
+      std::cerr << "Invalid prewarm" << std::endl;
+      return false;
+    }
+  }
+  params->prewarm_connect = cmdline.prewarm_connect;
+
+  params->async_dns = cmdline.async_dns;
+
   if (!cmdline.no_log) {
     if (!cmdline.log.empty()) {
       params->log_settings.logging_dest = logging::LOG_TO_FILE;
       params->log_settings.log_file_path = cmdline.log.value().c_str();
+      params->log_path = cmdline.log;
     } else {
       params->log_settings.logging_dest = logging::LOG_TO_STDERR;
     }
@@ -335,8 +762,20 @@ bool ParseCommandLine(const CommandLine& cmdline, Params* params) {
     params->log_settings.logging_dest = logging::LOG_NONE;
   }
 
+  params->log_max_size = 0;
+  if (!cmdline.log_max_size.empty()) {
+    int megabytes;
+    if (!base::StringToInt(cmdline.log_max_size, &megabytes) ||
+        megabytes < 0) {
+      std::cerr << "Invalid log max size" << std::endl;
+      return false;
+    }
+    params->log_max_size = static_cast<int64_t>(megabytes) * 1024 * 1024;
+  }
+
   params->net_log_path = cmdline.log_net_log;
   params->ssl_key_path = cmdline.ssl_key_log_file;
+  params->startup_trace = cmdline.startup_trace;
 
   return true;
 }
@@ -391,6 +830,9 @@ std::unique_ptr<URLRequestContext> BuildCertURLRequestContext(NetLog* net_log) {
 
   builder.DisableHttpCache();
   builder.set_net_log(net_log);
+  // AIA and revocation fetches do not need the QUIC stack.
+  builder.SetSpdyAndQuicEnabled(/*spdy_enabled=*/true,
+                                /*quic_enabled=*/false);
 
   ProxyConfig proxy_config;
   auto proxy_service =
@@ -425,15 +867,50 @@ std::unique_ptr<URLRequestContext> BuildURLRequestContext(
   proxy_service->ForceReloadProxyConfig();
   builder.set_proxy_resolution_service(std::move(proxy_service));
 
-  if (!params.host_resolver_rules.empty()) {
+  if (params.async_dns) {
+    HostResolver::ManagerOptions options;
+    options.insecure_dns_client_enabled = true;
+    options.dns_config_overrides.reuse_sockets = true;
+    builder.set_host_resolver(HostResolver::CreateStandaloneResolver(
+        net_log, options, params.host_resolver_rules,
+        /*enable_caching=*/true));
+  } else if (!params.host_resolver_rules.empty()) {
     builder.set_host_mapping_rules(params.host_resolver_rules);
   }
 
+  HttpNetworkSession::Params session_params;
+  // Keeps the QUIC stack unused unless the proxy needs it.
+  session_params.enable_quic = params.proxy_url.compare(0, 7, "quic://") == 0;
+  session_params.spdy_health_check_interval = params.health_check_interval;
+  session_params.http2_settings = params.http2_settings;
+  session_params.spdy_go_away_on_stream_cap = true;
+  session_params.spdy_session_recv_window_per_stream =
+      kSpdySessionRecvWindowPerTunnel;
+  builder.set_http_network_session_params(session_params);
+
   builder.SetCertVerifier(
       CertVerifier::CreateDefault(std::move(cert_net_fetcher)));
 
   builder.set_proxy_delegate(
-      std::make_unique<NaiveProxyDelegate>(params.extra_headers));
+      std::make_unique<NaiveProxyDelegate>(
+          params.extra_headers, params.compression, params.padding_policy));
+
+  if (params.proxy_url.compare(0, 7, "quic://") == 0) {
+    // QuicStreamFactory copies these when the context is built.
+    auto quic_context = std::make_unique<QuicContext>();
+    auto* quic = quic_context->params();
+    // Buffers written to tunnels are never reused for later writes:
+    // NaiveConnection allocates a buffer per read, and sockets wrapping the
+    // tunnel, like CompressedSocket, allocate one per write.
+    quic->zero_copy_proxy_writes = true;
+#if defined(OS_LINUX)
+    // Keeps tunnels alive across uplink address changes and NAT rebinding
+    // by migrating sessions to a new port instead of closing them.
+    quic->allow_port_migration = true;
+    quic->migrate_sessions_on_ip_change = true;
+#endif
+    builder.set_quic_context(std::move(quic_context));
+  }
 
   auto context = builder.Build();
 
@@ -458,10 +935,24 @@ std::unique_ptr<URLRequestContext> BuildURLRequestContext(
 
   return context;
 }
+
+// The built-in DNS client needs nameservers from the system DNS config,
+// which is read in the background. Without them, or with resolver options it
+// cannot handle, lookups silently fall back to the system resolver.
+void WarnIfDnsClientUnused(HostResolver* host_resolver) {
+  base::Value config = host_resolver->GetDnsConfigAsValue();
+  const base::Value* nameservers = config.FindListKey("nameservers");
+  if (!nameservers || nameservers->GetList().empty() ||
+      config.FindBoolKey("unhandled_options").value_or(false)) {
+    LOG(WARNING) << "Built-in DNS client unused, resolving with the system "
+                    "resolver instead";
+  }
+}
 }  // namespace
 }  // namespace net
 
 int main(int argc, char* argv[]) {
+  StartupTrace startup_trace;
   url::AddStandardScheme("quic",
                          url::SCHEME_WITH_HOST_PORT_AND_USER_INFORMATION);
   base::FeatureList::InitializeInstance(
@@ -475,6 +966,7 @@ int main(int argc, char* argv[]) {
 #endif
 
   base::CommandLine::Init(argc, argv);
+  startup_trace.Mark("init");
 
   CommandLine cmdline;
   Params params;
@@ -494,6 +986,7 @@ int main(int argc, char* argv[]) {
   if (!ParseCommandLine(cmdline, &params)) {
     return EXIT_FAILURE;
   }
+  startup_trace.Mark("config");
 
   net::ClientSocketPoolManager::set_max_sockets_per_pool(
       net::HttpNetworkSession::NORMAL_SOCKET_POOL,
@@ -506,6 +999,10 @@ int main(int argc, char* argv[]) {
       kDefaultMaxSocketsPerGroup * kExpectedMaxUsers);
 
   CHECK(logging::InitLogging(params.log_settings));
+  if (!params.log_path.empty()) {
+    // Keeps file writes off the network thread.
+    CHECK(net::AsyncLogSink::Install(params.log_path, params.log_max_size));
+  }
 
   if (!params.ssl_key_path.empty()) {
     net::SSLClientSocket::SetSSLKeyLogger(
@@ -532,55 +1029,108 @@ int main(int argc, char* argv[]) {
                          net::NetLogCaptureMode::kDefault);
   }
 
-  auto cert_context = net::BuildCertURLRequestContext(net_log);
+  startup_trace.Mark("logging");
+
+  // Watches local address changes (AddressTrackerLinux on Linux) so that QUIC
+  // proxy sessions can migrate. Also delivers the system DNS config to the
+  // built-in DNS client. Must be created before the contexts.
+  std::unique_ptr<net::NetworkChangeNotifier> network_change_notifier;
+  bool watches_network = params.async_dns;
+#if defined(OS_LINUX)
+  if (params.proxy_url.compare(0, 7, "quic://") == 0) {
+    watches_network = true;
+  }
+#endif
+  if (watches_network) {
+    network_change_notifier = net::NetworkChangeNotifier::CreateIfNeeded();
+  }
+
+  // Certificates are only verified for the proxy and the DoH server. In
+  // direct mode without them, the cert fetching context is not built.
+  bool verifies_certs =
+      params.proxy_url != "direct://" || params.resolver_doh_url.is_valid();
+
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  // Loads the system trust store in the background, so that verifying the
+  // proxy certificate for the first tunnel does not wait for it.
+  if (verifies_certs) {
+    base::ThreadPool::PostTask(
+        FROM_HERE, {base::MayBlock(), base::TaskPriority::USER_BLOCKING},
+        base::BindOnce(
+            [] { net::CreateSslSystemTrustStore()->GetTrustStore(); }));
+  }
+#endif
+
+  std::unique_ptr<net::URLRequestContext> cert_context;
   scoped_refptr<net::CertNetFetcherURLRequest> cert_net_fetcher;
 #if defined(OS_LINUX) || defined(OS_MAC) || defined(OS_ANDROID)
-  cert_net_fetcher = base::MakeRefCounted<net::CertNetFetcherURLRequest>();
-  cert_net_fetcher->SetURLRequestContext(cert_context.get());
+  if (verifies_certs) {
+    cert_context = net::BuildCertURLRequestContext(net_log);
+    cert_net_fetcher = base::MakeRefCounted<net::CertNetFetcherURLRequest>();
+    cert_net_fetcher->SetURLRequestContext(cert_context.get());
+  }
 #endif
   auto context =
       net::BuildURLRequestContext(params, std::move(cert_net_fetcher), net_log);
   auto* session = context->http_transaction_factory()->GetSession();
+  startup_trace.Mark("contexts");
 
-  auto listen_socket =
-      std::make_unique<net::TCPServerSocket>(net_log, net::NetLogSource());
-
-  int result = listen_socket->ListenWithAddressAndPort(
-      params.listen_addr, params.listen_port, kListenBackLog);
-  if (result != net::OK) {
-    LOG(ERROR) << "Failed to listen: " << result;
-    return EXIT_FAILURE;
+  if (params.async_dns) {
+    base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+        FROM_HERE,
+        base::BindOnce(&net::WarnIfDnsClientUnused, context->host_resolver()),
+        base::TimeDelta::FromSeconds(kDnsConfigTimeoutSeconds));
   }
-  LOG(INFO) << "Listening on " << params.listen_addr << ":"
-            << params.listen_port;
-
-  std::unique_ptr<net::RedirectResolver> resolver;
-  if (params.protocol == net::ClientProtocol::kRedir) {
-    auto resolver_socket =
-        std::make_unique<net::UDPServerSocket>(net_log, net::NetLogSource());
-    resolver_socket->AllowAddressReuse();
-    net::IPAddress listen_addr;
-    if (!listen_addr.AssignFromIPLiteral(params.listen_addr)) {
-      LOG(ERROR) << "Failed to open resolver: " << net::ERR_ADDRESS_INVALID;
-      return EXIT_FAILURE;
-    }
 
-    result = resolver_socket->Listen(
-        net::IPEndPoint(listen_addr, params.listen_port));
+  std::vector<std::unique_ptr<net::RedirectResolver>> resolvers;
+  std::vector<std::unique_ptr<net::NaiveProxy>> naive_proxies;
+  for (const auto& listen : params.listen) {
+    std::unique_ptr<net::TCPServerSocket> listen_socket;
+    int result = ListenTCP(listen, net_log, &listen_socket);
     if (result != net::OK) {
-      LOG(ERROR) << "Failed to open resolver: " << result;
+      LOG(ERROR) << "Failed to listen: " << result;
       return EXIT_FAILURE;
     }
+    LOG(INFO) << "Listening on " << listen.listen_addr << ":"
+              << listen.listen_port;
 
-    resolver = std::make_unique<net::RedirectResolver>(
-        std::move(resolver_socket), params.resolver_range,
-        params.resolver_prefix);
-  }
+    net::RedirectResolver* resolver = nullptr;
+    if (listen.protocol == net::ClientProtocol::kRedir) {
+      auto resolver_socket =
+          std::make_unique<net::UDPServerSocket>(net_log, net::NetLogSource());
+      resolver_socket->AllowAddressReuse();
+      net::IPAddress listen_addr;
+      if (!listen_addr.AssignFromIPLiteral(listen.listen_addr)) {
+        LOG(ERROR) << "Failed to open resolver: " << net::ERR_ADDRESS_INVALID;
+        return EXIT_FAILURE;
+      }
+
+      result = resolver_socket->Listen(
+          net::IPEndPoint(listen_addr, listen.listen_port));
+      if (result != net::OK) {
+        LOG(ERROR) << "Failed to open resolver: " << result;
+        return EXIT_FAILURE;
+      }
 
-  net::NaiveProxy naive_proxy(std::move(listen_socket), params.protocol,
-                              params.listen_user, params.listen_pass,
-                              params.concurrency, resolver.get(), session,
-                              kTrafficAnnotation);
+      resolvers.push_back(std::make_unique<net::RedirectResolver>(
+          std::move(resolver_socket), params.resolver_range,
+          params.resolver_prefix, params.resolver_doh_url, context.get(),
+          kTrafficAnnotation));
+      resolver = resolvers.back().get();
+    }
+
+    naive_proxies.push_back(std::make_unique<net::NaiveProxy>(
+        std::move(listen_socket), listen.protocol, listen.listen_user,
+        listen.listen_pass, params.concurrency, params.connect_timeout,
+        params.idle_timeout, params.hedge_connect, listen.priority,
+        listen.max_rate, listen.accept_rate, listen.accept_rate_per_ip,
+        params.prewarm_origins, params.prewarm_connect, resolver, session,
+        kTrafficAnnotation));
+  }
+  startup_trace.Mark("listen");
+  if (params.startup_trace) {
+    startup_trace.Report();
+  }
 
   base::RunLoop().Run();
 
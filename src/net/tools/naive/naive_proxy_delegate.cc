@@ -44,8 +44,12 @@ void FillNonindexHeaderValue(uint64_t unique_bits, char* buf, int len) {
   }
 }
 
-NaiveProxyDelegate::NaiveProxyDelegate(const HttpRequestHeaders& extra_headers)
-    : extra_headers_(extra_headers) {
+NaiveProxyDelegate::NaiveProxyDelegate(const HttpRequestHeaders& extra_headers,
+                                       bool compression,
+                                       const PaddingPolicy& padding_policy)
+    : extra_headers_(extra_headers),
+      compression_(compression),
+      padding_policy_(padding_policy) {
   InitializeNonindexCodes();
 }
 
@@ -61,12 +65,23 @@ void NaiveProxyDelegate::OnBeforeTunnelRequest(
   std::string padding(base::RandInt(16, 32), '~');
   FillNonindexHeaderValue(base::RandUint64(), &padding[0], padding.size());
   extra_headers->SetHeader("padding", padding);
+  // Servers that do not echo this header pad by the default policy.
+  if (!padding_policy_.IsDefault()) {
+    extra_headers->SetHeader("padding-policy", padding_policy_.ToString());
+  }
 
   // Enables Fast Open in H2/H3 proxy client socket once the state of server
-  // padding support is known.
-  if (padding_state_by_server_[proxy_server] != PaddingSupport::kUnknown) {
+  // padding support is known. Compressed tunnels and tunnels proposing a
+  // padding policy wait for their own response, which decides how the first
+  // bytes are framed.
+  if (padding_state_by_server_[proxy_server] != PaddingSupport::kUnknown &&
+      !compression_ && padding_policy_.IsDefault()) {
     extra_headers->SetHeader("fastopen", "1");
   }
+  // The proxy compresses the tunnel if it echoes this header.
+  if (compression_) {
+    extra_headers->SetHeader("compression", "deflate");
+  }
   extra_headers->MergeFrom(extra_headers_);
 }
 
@@ -86,6 +101,18 @@ Error NaiveProxyDelegate::OnTunnelHeadersReceived(
               << (padding ? " detected" : " undetected");
   }
   padding_state = new_state;
+
+  // The server may answer with a policy other than the proposed one. The
+  // tunnel reads it from its own response later.
+  PaddingPolicy padding_policy;
+  std::string padding_policy_spec;
+  if (padding && !padding_policy_.IsDefault() &&
+      response_headers.GetNormalizedHeader("padding-policy",
+                                           &padding_policy_spec) &&
+      !PaddingPolicy::Parse(padding_policy_spec, &padding_policy)) {
+    LOG(WARNING) << "Invalid padding policy from " << proxy_server.ToURI();
+    return ERR_TUNNEL_CONNECTION_FAILED;
+  }
   return OK;
 }
 
@@ -98,6 +125,28 @@ PaddingSupport NaiveProxyDelegate::GetProxyServerPaddingSupport(
   return padding_state_by_server_[proxy_server];
 }
 
+bool NaiveProxyDelegate::IsTunnelCompressed(
+    const HttpResponseHeaders& headers) const {
+  std::string compression;
+  return compression_ &&
+         headers.GetNormalizedHeader("compression", &compression) &&
+         compression == "deflate";
+}
+
+PaddingPolicy NaiveProxyDelegate::GetTunnelPaddingPolicy(
+    const HttpResponseHeaders& headers) const {
+  // Servers that do not echo a policy pad by the default one.
+  PaddingPolicy padding_policy;
+  std::string padding_policy_spec;
+  if (!padding_policy_.IsDefault() && headers.HasHeader("padding") &&
+      headers.GetNormalizedHeader("padding-policy", &padding_policy_spec)) {
+    // Already validated by OnTunnelHeadersReceived().
+    bool valid = PaddingPolicy::Parse(padding_policy_spec, &padding_policy);
+    DCHECK(valid);
+  }
+  return padding_policy;
+}
+
 PaddingDetectorDelegate::PaddingDetectorDelegate(
     NaiveProxyDelegate* naive_proxy_delegate,
     const ProxyServer& proxy_server,
@@ -106,7 +155,8 @@ PaddingDetectorDelegate::PaddingDetectorDelegate(
       proxy_server_(proxy_server),
       client_protocol_(client_protocol),
       detected_client_padding_support_(PaddingSupport::kUnknown),
-      cached_server_padding_support_(PaddingSupport::kUnknown) {}
+      cached_server_padding_support_(PaddingSupport::kUnknown),
+      server_compression_(false) {}
 
 PaddingDetectorDelegate::~PaddingDetectorDelegate() = default;
 
@@ -136,6 +186,29 @@ void PaddingDetectorDelegate::SetClientPaddingSupport(
   detected_client_padding_support_ = padding_support;
 }
 
+void PaddingDetectorDelegate::SetClientPaddingPolicy(
+    const PaddingPolicy& padding_policy) {
+  detected_client_padding_policy_ = padding_policy;
+}
+
+const PaddingPolicy& PaddingDetectorDelegate::GetPaddingPolicy() {
+  // The padded side is the one that is padding capable.
+  if (GetPaddingDirection() == kServer)
+    return detected_client_padding_policy_;
+  return server_padding_policy_;
+}
+
+bool PaddingDetectorDelegate::IsServerCompressionEnabled() {
+  return server_compression_;
+}
+
+void PaddingDetectorDelegate::SetServerTunnelResponse(
+    const HttpResponseHeaders& headers) {
+  server_padding_policy_ =
+      naive_proxy_delegate_->GetTunnelPaddingPolicy(headers);
+  server_compression_ = naive_proxy_delegate_->IsTunnelCompressed(headers);
+}
+
 PaddingSupport PaddingDetectorDelegate::GetClientPaddingSupport() {
   // Not possible to detect padding capability given underlying protocol.
   if (client_protocol_ == ClientProtocol::kSocks5) {
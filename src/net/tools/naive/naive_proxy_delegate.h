@@ -14,6 +14,7 @@
 #include "net/base/proxy_server.h"
 #include "net/proxy_resolution/proxy_retry_info.h"
 #include "net/tools/naive/naive_protocol.h"
+#include "net/tools/naive/padding_policy.h"
 #include "url/gurl.h"
 
 namespace net {
@@ -34,7 +35,11 @@ enum class PaddingSupport {
 
 class NaiveProxyDelegate : public ProxyDelegate {
  public:
-  explicit NaiveProxyDelegate(const HttpRequestHeaders& extra_headers);
+  // If |compression| is set, asks the proxy to compress tunnels. Proposes
+  // |padding_policy| to the proxy unless it is the default.
+  NaiveProxyDelegate(const HttpRequestHeaders& extra_headers,
+                     bool compression,
+                     const PaddingPolicy& padding_policy);
   ~NaiveProxyDelegate() override;
 
   void OnResolveProxy(const GURL& url,
@@ -53,8 +58,18 @@ class NaiveProxyDelegate : public ProxyDelegate {
 
   PaddingSupport GetProxyServerPaddingSupport(const ProxyServer& proxy_server);
 
+  // Whether the tunnel with the CONNECT response |headers| is compressed.
+  bool IsTunnelCompressed(const HttpResponseHeaders& headers) const;
+
+  // The padding policy the tunnel with the CONNECT response |headers| agreed
+  // on.
+  PaddingPolicy GetTunnelPaddingPolicy(
+      const HttpResponseHeaders& headers) const;
+
  private:
   const HttpRequestHeaders& extra_headers_;
+  const bool compression_;
+  const PaddingPolicy padding_policy_;
   std::map<ProxyServer, PaddingSupport> padding_state_by_server_;
 };
 
@@ -63,6 +78,7 @@ class ClientPaddingDetectorDelegate {
   virtual ~ClientPaddingDetectorDelegate() = default;
 
   virtual void SetClientPaddingSupport(PaddingSupport padding_support) = 0;
+  virtual void SetClientPaddingPolicy(const PaddingPolicy& padding_policy) = 0;
 };
 
 class PaddingDetectorDelegate : public ClientPaddingDetectorDelegate {
@@ -74,7 +90,16 @@ class PaddingDetectorDelegate : public ClientPaddingDetectorDelegate {
 
   bool IsPaddingSupportKnown();
   Direction GetPaddingDirection();
+  // Whether traffic to and from the server is compressed. Only valid after
+  // SetServerTunnelResponse().
+  bool IsServerCompressionEnabled();
+  // Takes what the tunnel agreed on from its own CONNECT response.
+  void SetServerTunnelResponse(const HttpResponseHeaders& headers);
+  // The policy of the padded side. Only valid once padding support is known,
+  // and for the server side after SetServerTunnelResponse().
+  const PaddingPolicy& GetPaddingPolicy();
   void SetClientPaddingSupport(PaddingSupport padding_support) override;
+  void SetClientPaddingPolicy(const PaddingPolicy& padding_policy) override;
 
  private:
   PaddingSupport GetClientPaddingSupport();
@@ -85,9 +110,12 @@ class PaddingDetectorDelegate : public ClientPaddingDetectorDelegate {
   ClientProtocol client_protocol_;
 
   PaddingSupport detected_client_padding_support_;
+  PaddingPolicy detected_client_padding_policy_;
   // The result is only cached during one connection, so it's still dynamically
   // updated in the following connections after server changes support.
   PaddingSupport cached_server_padding_support_;
+  PaddingPolicy server_padding_policy_;
+  bool server_compression_;
 };
 
 }  // namespace net
@@ -0,0 +1,446 @@
+// Copyright 2021 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Measures the throughput and the bytes overhead of padding policies. For each
+// policy a client opens a padded HTTP CONNECT tunnel to a NaiveProxy listener
+// on loopback, which relays a download from a local origin server through
+// NaiveConnection's padding path. The client removes the padding and checks
+// that the payload arrives intact.
+//
+// Usage: naive_padding_bench [--bytes=<N>] [--chunk=<N>]
+//                            [--policies=<spec>;<spec>;...]
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/at_exit.h"
+#include "base/bind.h"
+#include "base/callback.h"
+#include "base/command_line.h"
+#include "base/feature_list.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "base/strings/stringprintf.h"
+#include "base/task/single_thread_task_executor.h"
+#include "base/task/thread_pool/thread_pool_instance.h"
+#include "base/time/time.h"
+#include "net/base/address_list.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/io_buffer.h"
+#include "net/base/ip_address.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_errors.h"
+#include "net/http/http_request_headers.h"
+#include "net/log/net_log.h"
+#include "net/log/net_log_source.h"
+#include "net/proxy_resolution/configured_proxy_resolution_service.h"
+#include "net/proxy_resolution/proxy_config.h"
+#include "net/proxy_resolution/proxy_config_service_fixed.h"
+#include "net/proxy_resolution/proxy_config_with_annotation.h"
+#include "net/socket/stream_socket.h"
+#include "net/socket/tcp_client_socket.h"
+#include "net/socket/tcp_server_socket.h"
+#include "net/tools/naive/naive_protocol.h"
+#include "net/tools/naive/naive_proxy.h"
+#include "net/tools/naive/naive_proxy_delegate.h"
+#include "net/tools/naive/padding_policy.h"
+#include "net/traffic_annotation/network_traffic_annotation.h"
+#include "net/url_request/url_request_context.h"
+#include "net/url_request/url_request_context_builder.h"
+
+namespace net {
+namespace {
+
+constexpr NetworkTrafficAnnotationTag kTrafficAnnotation =
+    DefineNetworkTrafficAnnotation("naive_padding_bench", "");
+
+constexpr int64_t kDefaultBytes = 64 * 1024 * 1024;
+constexpr int kDefaultChunkSize = 16 * 1024;
+// The default policy, no padding, and a few trade-offs in between.
+constexpr char kDefaultPolicies[] =
+    ";frames=0;frames=8,max=64;frames=32,min=128,budget=4096;"
+    "frames=255,stop-after=1048576";
+constexpr int kReadBufferSize = 64 * 1024;
+constexpr int kPaddingHeaderSize = 3;
+
+// Accepts one connection and writes |bytes| bytes to it in writes of
+// |chunk_size| bytes, then closes it.
+class Origin {
+ public:
+  Origin(int64_t bytes, int chunk_size)
+      : bytes_left_(bytes),
+        buffer_(base::MakeRefCounted<IOBuffer>(chunk_size)),
+        chunk_size_(chunk_size) {
+    std::fill(buffer_->data(), buffer_->data() + chunk_size, 'x');
+  }
+  Origin(const Origin&) = delete;
+  Origin& operator=(const Origin&) = delete;
+
+  int Listen(IPEndPoint* endpoint) {
+    listen_socket_ =
+        std::make_unique<TCPServerSocket>(NetLog::Get(), NetLogSource());
+    int rv = listen_socket_->Listen(IPEndPoint(IPAddress::IPv4Localhost(), 0),
+                                    /*backlog=*/1);
+    if (rv != OK)
+      return rv;
+    rv = listen_socket_->GetLocalAddress(endpoint);
+    if (rv != OK)
+      return rv;
+    rv = listen_socket_->Accept(
+        &socket_, base::BindOnce(&Origin::OnAccept, base::Unretained(this)));
+    if (rv != ERR_IO_PENDING)
+      OnAccept(rv);
+    return OK;
+  }
+
+ private:
+  void OnAccept(int result) {
+    if (result != OK)
+      return;
+    DoWrite();
+  }
+
+  void DoWrite() {
+    for (;;) {
+      if (!write_buffer_) {
+        if (bytes_left_ == 0) {
+          socket_->Disconnect();
+          return;
+        }
+        int size =
+            static_cast<int>(std::min<int64_t>(chunk_size_, bytes_left_));
+        bytes_left_ -= size;
+        write_buffer_ = base::MakeRefCounted<DrainableIOBuffer>(buffer_, size);
+      }
+      int rv = socket_->Write(
+          write_buffer_.get(), write_buffer_->BytesRemaining(),
+          base::BindOnce(&Origin::OnWriteComplete, base::Unretained(this)),
+          kTrafficAnnotation);
+      if (rv == ERR_IO_PENDING)
+        return;
+      if (rv < 0)
+        return;
+      DidWrite(rv);
+    }
+  }
+
+  void OnWriteComplete(int result) {
+    if (result < 0)
+      return;
+    DidWrite(result);
+    DoWrite();
+  }
+
+  void DidWrite(int result) {
+    write_buffer_->DidConsume(result);
+    if (write_buffer_->BytesRemaining() == 0)
+      write_buffer_ = nullptr;
+  }
+
+  int64_t bytes_left_;
+  scoped_refptr<IOBuffer> buffer_;
+  const int chunk_size_;
+  std::unique_ptr<TCPServerSocket> listen_socket_;
+  std::unique_ptr<StreamSocket> socket_;
+  scoped_refptr<DrainableIOBuffer> write_buffer_;
+};
+
+// Downloads through a padded tunnel and removes the padding like the
+// receiving end of NaiveConnection does.
+class Client {
+ public:
+  Client(const IPEndPoint& proxy,
+         const HostPortPair& origin,
+         const PaddingPolicy& policy,
+         base::OnceClosure done)
+      : socket_(std::make_unique<TCPClientSocket>(AddressList(proxy),
+                                                  nullptr,
+                                                  NetLog::Get(),
+                                                  NetLogSource())),
+        origin_(origin),
+        policy_(policy),
+        done_(std::move(done)),
+        read_buffer_(base::MakeRefCounted<IOBuffer>(kReadBufferSize)) {}
+  Client(const Client&) = delete;
+  Client& operator=(const Client&) = delete;
+
+  void Start() {
+    int rv = socket_->Connect(
+        base::BindOnce(&Client::OnConnectComplete, base::Unretained(this)));
+    if (rv != ERR_IO_PENDING)
+      OnConnectComplete(rv);
+  }
+
+  int result() const { return result_; }
+  int64_t wire_bytes() const { return wire_bytes_; }
+  int64_t payload_bytes() const { return payload_bytes_; }
+  int frames() const { return frames_; }
+
+ private:
+  void OnConnectComplete(int result) {
+    if (result != OK) {
+      Finish(result);
+      return;
+    }
+    std::string request = "CONNECT " + origin_.ToString() +
+                          " HTTP/1.1\r\nPadding: " + std::string(16, '~') +
+                          "\r\n";
+    if (!policy_.IsDefault())
+      request += "Padding-Policy: " + policy_.ToString() + "\r\n";
+    request += "\r\n";
+    auto buffer = base::MakeRefCounted<StringIOBuffer>(request);
+    // Loopback takes a request this small in one write.
+    int rv = socket_->Write(
+        buffer.get(), buffer->size(),
+        base::BindOnce(&Client::OnRequestWritten, base::Unretained(this)),
+        kTrafficAnnotation);
+    if (rv != ERR_IO_PENDING)
+      OnRequestWritten(rv);
+  }
+
+  void OnRequestWritten(int result) {
+    if (result < 0) {
+      Finish(result);
+      return;
+    }
+    DoRead();
+  }
+
+  void DoRead() {
+    for (;;) {
+      int rv = socket_->Read(
+          read_buffer_.get(), kReadBufferSize,
+          base::BindOnce(&Client::OnReadComplete, base::Unretained(this)));
+      if (rv == ERR_IO_PENDING)
+        return;
+      if (!DidRead(rv))
+        return;
+    }
+  }
+
+  void OnReadComplete(int result) {
+    if (DidRead(result))
+      DoRead();
+  }
+
+  // Returns false when the download is over.
+  bool DidRead(int result) {
+    if (result <= 0) {
+      Finish(result);
+      return false;
+    }
+    const char* p = read_buffer_->data();
+    int size = result;
+    if (!headers_done_) {
+      response_.append(p, size);
+      size_t end = response_.find("\r\n\r\n");
+      if (end == std::string::npos)
+        return true;
+      if (response_.compare(0, 12, "HTTP/1.1 200") != 0) {
+        Finish(ERR_TUNNEL_CONNECTION_FAILED);
+        return false;
+      }
+      headers_done_ = true;
+      std::string body = response_.substr(end + 4);
+      Consume(body.data(), body.size());
+      return true;
+    }
+    Consume(p, size);
+    return true;
+  }
+
+  void Consume(const char* p, int size) {
+    wire_bytes_ += size;
+    for (int i = 0; i < size;) {
+      bool at_frame_start =
+          header_pos_ == 0 && payload_left_ == 0 && padding_left_ == 0;
+      if (at_frame_start &&
+          !policy_.ShouldPad(frames_, padding_bytes_, payload_bytes_)) {
+        payload_bytes_ += size - i;
+        return;
+      }
+      if (header_pos_ < kPaddingHeaderSize) {
+        header_[header_pos_++] = static_cast<uint8_t>(p[i++]);
+        if (header_pos_ == kPaddingHeaderSize) {
+          payload_left_ = header_[0] * 256 + header_[1];
+          padding_left_ = header_[2];
+          // Counted like the sender counts them.
+          ++frames_;
+          payload_bytes_ += payload_left_;
+          padding_bytes_ += padding_left_;
+        }
+        continue;
+      }
+      int copy_size = std::min(size - i, payload_left_ + padding_left_);
+      int payload_size = std::min(copy_size, payload_left_);
+      payload_left_ -= payload_size;
+      padding_left_ -= copy_size - payload_size;
+      i += copy_size;
+      if (payload_left_ == 0 && padding_left_ == 0)
+        header_pos_ = 0;
+    }
+  }
+
+  void Finish(int result) {
+    result_ = result;
+    socket_->Disconnect();
+    std::move(done_).Run();
+  }
+
+  std::unique_ptr<TCPClientSocket> socket_;
+  const HostPortPair origin_;
+  const PaddingPolicy policy_;
+  base::OnceClosure done_;
+  scoped_refptr<IOBuffer> read_buffer_;
+  std::string response_;
+  bool headers_done_ = false;
+  int result_ = OK;
+
+  int64_t wire_bytes_ = 0;
+  int64_t payload_bytes_ = 0;
+  int64_t padding_bytes_ = 0;
+  int frames_ = 0;
+  uint8_t header_[kPaddingHeaderSize] = {};
+  int header_pos_ = 0;
+  int payload_left_ = 0;
+  int padding_left_ = 0;
+};
+
+std::unique_ptr<URLRequestContext> BuildURLRequestContext(
+    const HttpRequestHeaders& extra_headers) {
+  URLRequestContextBuilder builder;
+  builder.DisableHttpCache();
+  builder.set_net_log(NetLog::Get());
+
+  ProxyConfig proxy_config;
+  proxy_config.proxy_rules().ParseFromString("direct://");
+  auto proxy_service =
+      ConfiguredProxyResolutionService::CreateWithoutProxyResolver(
+          std::make_unique<ProxyConfigServiceFixed>(
+              ProxyConfigWithAnnotation(proxy_config, kTrafficAnnotation)),
+          NetLog::Get());
+  proxy_service->ForceReloadProxyConfig();
+  builder.set_proxy_resolution_service(std::move(proxy_service));
+  builder.set_proxy_delegate(std::make_unique<NaiveProxyDelegate>(
+      extra_headers, /*compression=*/false, PaddingPolicy()));
+  return builder.Build();
+}
+
+// Returns false if the tunnel failed.
+bool RunPolicy(const IPEndPoint& proxy,
+               const PaddingPolicy& policy,
+               int64_t bytes,
+               int chunk_size) {
+  Origin origin(bytes, chunk_size);
+  IPEndPoint origin_endpoint;
+  int rv = origin.Listen(&origin_endpoint);
+  if (rv != OK) {
+    std::cerr << "Failed to listen: " << ErrorToShortString(rv) << std::endl;
+    return false;
+  }
+
+  base::RunLoop run_loop;
+  Client client(proxy, HostPortPair::FromIPEndPoint(origin_endpoint), policy,
+                run_loop.QuitClosure());
+  base::TimeTicks start = base::TimeTicks::Now();
+  client.Start();
+  run_loop.Run();
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+  std::string name = policy.IsDefault() ? "default" : policy.ToString();
+  if (client.result() != OK || client.payload_bytes() != bytes) {
+    std::cerr << name << ": tunnel failed: "
+              << ErrorToShortString(client.result()) << ", "
+              << client.payload_bytes() << " of " << bytes << " bytes"
+              << std::endl;
+    return false;
+  }
+  int64_t overhead = client.wire_bytes() - client.payload_bytes();
+  std::cout << base::StringPrintf(
+                   "%-48s %9.1f MB/s %4d frames %7lld B overhead (%.4f%%)",
+                   name.c_str(), bytes / elapsed.InSecondsF() / 1e6,
+                   client.frames(), static_cast<long long>(overhead),
+                   100.0 * overhead / bytes)
+            << std::endl;
+  return true;
+}
+
+int Run() {
+  const auto& proc = *base::CommandLine::ForCurrentProcess();
+  int64_t bytes = kDefaultBytes;
+  int chunk_size = kDefaultChunkSize;
+  std::string policies = kDefaultPolicies;
+  if (proc.HasSwitch("bytes") &&
+      (!base::StringToInt64(proc.GetSwitchValueASCII("bytes"), &bytes) ||
+       bytes <= 0)) {
+    std::cerr << "Invalid bytes" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (proc.HasSwitch("chunk") &&
+      (!base::StringToInt(proc.GetSwitchValueASCII("chunk"), &chunk_size) ||
+       chunk_size <= 0)) {
+    std::cerr << "Invalid chunk" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (proc.HasSwitch("policies"))
+    policies = proc.GetSwitchValueASCII("policies");
+
+  HttpRequestHeaders extra_headers;
+  auto context = BuildURLRequestContext(extra_headers);
+  auto* session = context->http_transaction_factory()->GetSession();
+
+  auto listen_socket =
+      std::make_unique<TCPServerSocket>(NetLog::Get(), NetLogSource());
+  int rv = listen_socket->Listen(IPEndPoint(IPAddress::IPv4Localhost(), 0),
+                                 /*backlog=*/16);
+  IPEndPoint proxy_endpoint;
+  if (rv == OK)
+    rv = listen_socket->GetLocalAddress(&proxy_endpoint);
+  if (rv != OK) {
+    std::cerr << "Failed to listen: " << ErrorToShortString(rv) << std::endl;
+    return EXIT_FAILURE;
+  }
+  NaiveProxy naive_proxy(
+      std::move(listen_socket), ClientProtocol::kHttp, /*listen_user=*/"",
+      /*listen_pass=*/"", /*concurrency=*/1,
+      /*connect_timeout=*/base::TimeDelta(), /*idle_timeout=*/base::TimeDelta(),
+      /*hedge_connect=*/false, LOWEST, /*max_rate=*/0, /*accept_rate=*/0,
+      /*accept_rate_per_address=*/0, /*prewarm_origins=*/0,
+      /*prewarm_connect=*/false, /*resolver=*/nullptr, session,
+      kTrafficAnnotation);
+
+  bool ok = true;
+  for (const auto& spec : base::SplitString(
+           policies, ";", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL)) {
+    PaddingPolicy policy;
+    if (!PaddingPolicy::Parse(spec, &policy)) {
+      std::cerr << "Invalid padding policy: " << spec << std::endl;
+      return EXIT_FAILURE;
+    }
+    ok = RunPolicy(proxy_endpoint, policy, bytes, chunk_size) && ok;
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+}  // namespace
+}  // namespace net
+
+int main(int argc, char* argv[]) {
+  base::FeatureList::InitializeInstance(
+      "PartitionConnectionsByNetworkIsolationKey", std::string());
+  base::SingleThreadTaskExecutor io_task_executor(base::MessagePumpType::IO);
+  base::ThreadPoolInstance::CreateAndStartWithDefaultParams(
+      "naive_padding_bench");
+  base::AtExitManager exit_manager;
+  base::CommandLine::Init(argc, argv);
+  return net::Run();
+}
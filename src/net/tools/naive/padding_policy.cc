@@ -0,0 +1,92 @@
+// Copyright 2021 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/padding_policy.h"
+
+#include <algorithm>
+
+#include "base/rand_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "base/strings/stringprintf.h"
+
+namespace net {
+
+// static
+bool PaddingPolicy::Parse(base::StringPiece spec, PaddingPolicy* policy) {
+  PaddingPolicy result;
+  base::StringPairs pairs;
+  if (!spec.empty() &&
+      !base::SplitStringIntoKeyValuePairs(spec, '=', ',', &pairs)) {
+    return false;
+  }
+
+  for (const auto& pair : pairs) {
+    bool ok;
+    if (pair.first == "frames") {
+      ok = base::StringToInt(pair.second, &result.frames);
+    } else if (pair.first == "min") {
+      ok = base::StringToInt(pair.second, &result.min_size);
+    } else if (pair.first == "max") {
+      ok = base::StringToInt(pair.second, &result.max_size);
+    } else if (pair.first == "budget") {
+      ok = base::StringToInt64(pair.second, &result.budget);
+    } else if (pair.first == "stop-after") {
+      ok = base::StringToInt64(pair.second, &result.stop_after);
+    } else {
+      ok = false;
+    }
+    if (!ok)
+      return false;
+  }
+
+  if (result.frames < 0 || result.frames > kMaxFrames)
+    return false;
+  if (result.min_size < 0 || result.min_size > result.max_size ||
+      result.max_size > kMaxPaddingSize) {
+    return false;
+  }
+  if (result.budget < 0 || result.stop_after < 0)
+    return false;
+
+  *policy = result;
+  return true;
+}
+
+std::string PaddingPolicy::ToString() const {
+  return base::StringPrintf(
+      "frames=%d,min=%d,max=%d,budget=%lld,stop-after=%lld", frames, min_size,
+      max_size, static_cast<long long>(budget),
+      static_cast<long long>(stop_after));
+}
+
+bool PaddingPolicy::IsDefault() const {
+  return *this == PaddingPolicy();
+}
+
+bool PaddingPolicy::ShouldPad(int frames_sent,
+                              int64_t padding_bytes,
+                              int64_t payload_bytes) const {
+  if (frames_sent >= frames)
+    return false;
+  if (budget > 0 && padding_bytes >= budget)
+    return false;
+  if (stop_after > 0 && payload_bytes >= stop_after)
+    return false;
+  return true;
+}
+
+int PaddingPolicy::PickPaddingSize(int64_t padding_bytes) const {
+  int size = base::RandInt(min_size, max_size);
+  if (budget > 0)
+    size = static_cast<int>(std::min<int64_t>(size, budget - padding_bytes));
+  return size;
+}
+
+bool PaddingPolicy::operator==(const PaddingPolicy& other) const {
+  return frames == other.frames && min_size == other.min_size &&
+         max_size == other.max_size && budget == other.budget &&
+         stop_after == other.stop_after;
+}
+
+}  // namespace net
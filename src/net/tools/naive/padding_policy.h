@@ -0,0 +1,59 @@
+// Copyright 2021 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_PADDING_POLICY_H_
+#define NET_TOOLS_NAIVE_PADDING_POLICY_H_
+
+#include <cstdint>
+#include <string>
+
+#include "base/strings/string_piece.h"
+
+namespace net {
+
+// Decides which reads of a padded tunnel are sent as padding frames, and how
+// much padding each frame carries. Both ends of a tunnel must agree on the
+// policy, because the receiver stops parsing frames by the same rule the
+// sender stops sending them.
+struct PaddingPolicy {
+  // The largest padding a frame can carry, bounded by its one-byte length.
+  static constexpr int kMaxPaddingSize = 255;
+  // Bounds the padding work a peer can ask for.
+  static constexpr int kMaxFrames = 255;
+
+  // Parses a spec such as "frames=8,min=0,max=255,budget=0,stop-after=0".
+  // Omitted keys keep their defaults. Returns false if the spec is invalid.
+  static bool Parse(base::StringPiece spec, PaddingPolicy* policy);
+
+  // Returns the spec that Parse() reads back into this policy.
+  std::string ToString() const;
+
+  bool IsDefault() const;
+
+  // Returns whether the next frame in a direction is padded, given the
+  // frames, padding bytes and payload bytes already sent in it.
+  bool ShouldPad(int frames_sent,
+                 int64_t padding_bytes,
+                 int64_t payload_bytes) const;
+
+  // Picks the padding size of the next frame, within the remaining budget.
+  int PickPaddingSize(int64_t padding_bytes) const;
+
+  bool operator==(const PaddingPolicy& other) const;
+  bool operator!=(const PaddingPolicy& other) const {
+    return !(*this == other);
+  }
+
+  // Pads at most this many frames per direction.
+  int frames = 8;
+  // Padding sizes are uniformly distributed in [min_size, max_size].
+  int min_size = 0;
+  int max_size = kMaxPaddingSize;
+  // Stops padding once this many padding bytes were sent. 0 is unlimited.
+  int64_t budget = 0;
+  // Stops padding once this many payload bytes were sent. 0 is unlimited.
+  int64_t stop_after = 0;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_PADDING_POLICY_H_
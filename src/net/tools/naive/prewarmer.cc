@@ -0,0 +1,143 @@
+// Copyright 2021 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/prewarmer.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/check.h"
+#include "net/base/net_errors.h"
+#include "net/base/network_isolation_key.h"
+#include "net/base/privacy_mode.h"
+#include "net/base/request_priority.h"
+#include "net/dns/public/secure_dns_policy.h"
+#include "net/http/http_network_session.h"
+#include "net/proxy_resolution/proxy_info.h"
+#include "net/socket/client_socket_pool_manager.h"
+#include "net/ssl/ssl_config.h"
+
+namespace net {
+
+namespace {
+// Shorter than the unused idle socket timeout of the socket pools so that
+// preconnected sockets are replaced before they expire.
+constexpr int kPrewarmIntervalSeconds = 10;
+// Bounds the memory used by the connect counts.
+constexpr size_t kMaxTrackedOrigins = 1024;
+// Origins connected to fewer times than this in the last intervals are not
+// worth warming up.
+constexpr int kMinHits = 2;
+// The socket pools count sockets in use toward this, so an origin with a
+// tunnel open has at most one spare socket.
+constexpr int kPreconnectSocketsPerOrigin = 2;
+}  // namespace
+
+Prewarmer::Prewarmer(
+    size_t max_origins,
+    bool connect,
+    const ProxyInfo& proxy_info,
+    const SSLConfig& server_ssl_config,
+    const SSLConfig& proxy_ssl_config,
+    const std::vector<NetworkIsolationKey>& network_isolation_keys,
+    HttpNetworkSession* session,
+    const NetLogWithSource& net_log)
+    : max_origins_(max_origins),
+      connect_(connect),
+      proxy_info_(proxy_info),
+      server_ssl_config_(server_ssl_config),
+      proxy_ssl_config_(proxy_ssl_config),
+      network_isolation_keys_(network_isolation_keys),
+      session_(session),
+      net_log_(net_log) {
+  DCHECK_GT(max_origins_, 0u);
+  DCHECK(proxy_info_.is_direct());
+  DCHECK(!network_isolation_keys_.empty());
+  timer_.Start(FROM_HERE, base::TimeDelta::FromSeconds(kPrewarmIntervalSeconds),
+               base::BindRepeating(&Prewarmer::OnTimer,
+                                   weak_ptr_factory_.GetWeakPtr()));
+}
+
+Prewarmer::~Prewarmer() = default;
+
+void Prewarmer::RecordConnect(const HostPortPair& origin) {
+  auto it = hits_.find(origin);
+  if (it != hits_.end()) {
+    ++it->second;
+    return;
+  }
+  // New origins are counted again once decay has made room.
+  if (hits_.size() >= kMaxTrackedOrigins)
+    return;
+  hits_.emplace(origin, 1);
+}
+
+void Prewarmer::OnTimer() {
+  std::vector<std::pair<int, HostPortPair>> hot;
+  for (const auto& origin_hits : hits_) {
+    if (origin_hits.second >= kMinHits)
+      hot.emplace_back(origin_hits.second, origin_hits.first);
+  }
+  size_t count = std::min(max_origins_, hot.size());
+  std::partial_sort(
+      hot.begin(), hot.begin() + count, hot.end(),
+      [](const std::pair<int, HostPortPair>& a,
+         const std::pair<int, HostPortPair>& b) { return a.first > b.first; });
+  hot.resize(count);
+
+  for (const auto& hits_origin : hot) {
+    // Connect jobs resolve through the host cache, so preconnects refresh it
+    // too.
+    if (connect_) {
+      Preconnect(hits_origin.second);
+    } else {
+      Resolve(hits_origin.second);
+    }
+  }
+
+  for (auto it = hits_.begin(); it != hits_.end();) {
+    it->second /= 2;
+    if (it->second == 0) {
+      it = hits_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void Prewarmer::Resolve(const HostPortPair& origin) {
+  if (resolve_requests_.count(origin))
+    return;
+
+  // Matches the host cache key used by raw connects. Fresh entries are
+  // served from the cache and expired ones are resolved again.
+  HostResolver::ResolveHostParameters parameters;
+  parameters.initial_priority = IDLE;
+  parameters.secure_dns_policy = SecureDnsPolicy::kDisable;
+  auto request = session_->host_resolver()->CreateRequest(
+      origin, network_isolation_keys_.front(), net_log_, parameters);
+  int rv = request->Start(base::BindOnce(&Prewarmer::OnResolveComplete,
+                                         weak_ptr_factory_.GetWeakPtr(),
+                                         origin));
+  if (rv == ERR_IO_PENDING)
+    resolve_requests_[origin] = std::move(request);
+}
+
+void Prewarmer::OnResolveComplete(const HostPortPair& origin, int result) {
+  resolve_requests_.erase(origin);
+}
+
+void Prewarmer::Preconnect(const HostPortPair& origin) {
+  // Raw connects rotate through the network isolation keys, each of which
+  // has its own socket group.
+  for (const auto& network_isolation_key : network_isolation_keys_) {
+    PreconnectSocketsForHttpRequest(
+        ClientSocketPoolManager::NORMAL_GROUP, origin, /*request_load_flags=*/0,
+        IDLE, session_, proxy_info_, server_ssl_config_, proxy_ssl_config_,
+        PRIVACY_MODE_DISABLED, network_isolation_key,
+        SecureDnsPolicy::kDisable, net_log_, kPreconnectSocketsPerOrigin);
+  }
+}
+
+}  // namespace net
@@ -0,0 +1,70 @@
+// Copyright 2021 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_PREWARMER_H_
+#define NET_TOOLS_NAIVE_PREWARMER_H_
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "base/memory/weak_ptr.h"
+#include "base/timer/timer.h"
+#include "net/base/host_port_pair.h"
+#include "net/dns/host_resolver.h"
+#include "net/log/net_log_with_source.h"
+
+namespace net {
+
+class HttpNetworkSession;
+class NetworkIsolationKey;
+class ProxyInfo;
+struct SSLConfig;
+
+// Tracks how often origins are connected to directly and periodically warms
+// up the hottest ones: their host cache entries are refreshed, and if
+// |connect| is set, idle sockets are preconnected into the groups that raw
+// connects take sockets from.
+class Prewarmer {
+ public:
+  // All references must outlive the prewarmer.
+  Prewarmer(size_t max_origins,
+            bool connect,
+            const ProxyInfo& proxy_info,
+            const SSLConfig& server_ssl_config,
+            const SSLConfig& proxy_ssl_config,
+            const std::vector<NetworkIsolationKey>& network_isolation_keys,
+            HttpNetworkSession* session,
+            const NetLogWithSource& net_log);
+  Prewarmer(const Prewarmer&) = delete;
+  Prewarmer& operator=(const Prewarmer&) = delete;
+  ~Prewarmer();
+
+  void RecordConnect(const HostPortPair& origin);
+
+ private:
+  void OnTimer();
+  void Resolve(const HostPortPair& origin);
+  void OnResolveComplete(const HostPortPair& origin, int result);
+  void Preconnect(const HostPortPair& origin);
+
+  const size_t max_origins_;
+  const bool connect_;
+  const ProxyInfo& proxy_info_;
+  const SSLConfig& server_ssl_config_;
+  const SSLConfig& proxy_ssl_config_;
+  const std::vector<NetworkIsolationKey>& network_isolation_keys_;
+  HttpNetworkSession* session_;
+  NetLogWithSource net_log_;
+
+  // Connect counts, halved every interval.
+  std::map<HostPortPair, int> hits_;
+  std::map<HostPortPair, std::unique_ptr<HostResolver::ResolveHostRequest>>
+      resolve_requests_;
+  base::RepeatingTimer timer_;
+
+  base::WeakPtrFactory<Prewarmer> weak_ptr_factory_{this};
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_PREWARMER_H_
@@ -0,0 +1,99 @@
+// Copyright 2021 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Times base::RandBytes and base::RandInt, which naive calls for every padded
+// frame, against reading the same number of bytes from the OS on every call,
+// which is what base::RandBytes did before it used BoringSSL's DRBG.
+//
+// Usage: naive_rand_bench [--iterations=<N>]
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "base/check.h"
+#include "base/command_line.h"
+#include "base/files/file_util.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/rand_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "build/build_config.h"
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr int kDefaultIterations = 1000000;
+
+// The previous base::RandBytes: the OS is asked for every request.
+void OsRandBytes(void* output, size_t output_length) {
+#if (defined(OS_LINUX) || defined(OS_CHROMEOS)) && defined(SYS_getrandom)
+  const long r =
+      HANDLE_EINTR(syscall(SYS_getrandom, output, output_length, 0));
+  if (output_length == static_cast<size_t>(r))
+    return;
+#endif
+  const bool success = base::ReadFromFD(
+      base::GetUrandomFD(), static_cast<char*>(output), output_length);
+  CHECK(success);
+}
+
+template <typename Function>
+void Time(const char* name, int iterations, Function function) {
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < iterations; ++i)
+    function();
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  std::cout << base::StringPrintf("%-28s %9.1f ns/call", name,
+                                  elapsed.InNanosecondsF() / iterations)
+            << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  base::CommandLine::Init(argc, argv);
+  const auto& proc = *base::CommandLine::ForCurrentProcess();
+  int iterations = kDefaultIterations;
+  if (proc.HasSwitch("iterations") &&
+      (!base::StringToInt(proc.GetSwitchValueASCII("iterations"),
+                          &iterations) ||
+       iterations <= 0)) {
+    std::cerr << "Invalid iterations" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Keeps the results observable so that the calls are not optimized out.
+  uint64_t sink = 0;
+  for (size_t size : {3, 8, 64}) {
+    uint8_t buffer[64];
+    std::string before = base::StringPrintf("os, %zu bytes", size);
+    Time(before.c_str(), iterations, [&] {
+      OsRandBytes(buffer, size);
+      sink += buffer[0];
+    });
+    std::string after = base::StringPrintf("RandBytes, %zu bytes", size);
+    Time(after.c_str(), iterations, [&] {
+      base::RandBytes(buffer, size);
+      sink += buffer[0];
+    });
+  }
+  // base::RandInt draws 8 bytes through base::RandUint64.
+  Time("os, RandInt(0, 255)", iterations, [&] {
+    uint64_t value;
+    OsRandBytes(&value, sizeof(value));
+    sink += value % 256;
+  });
+  Time("RandInt(0, 255)", iterations, [&] { sink += base::RandInt(0, 255); });
+
+  std::cerr << "(" << sink << ")" << std::endl;
+  return EXIT_SUCCESS;
+}
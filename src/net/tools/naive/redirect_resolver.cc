@@ -4,28 +4,114 @@
 
 #include "net/tools/naive/redirect_resolver.h"
 
+#include <algorithm>
 #include <cstring>
 #include <iterator>
 #include <utility>
 
 #include "base/logging.h"
+#include "base/big_endian.h"
+#include "base/memory/ptr_util.h"
+#include "base/strings/string_util.h"
 #include "base/threading/thread_task_runner_handle.h"
+#include "net/base/elements_upload_data_stream.h"
+#include "net/base/idempotency.h"
 #include "net/base/io_buffer.h"
+#include "net/base/load_flags.h"
 #include "net/base/net_errors.h"
+#include "net/base/upload_bytes_element_reader.h"
 #include "net/dns/dns_query.h"
 #include "net/dns/dns_response.h"
 #include "net/dns/dns_util.h"
+#include "net/dns/public/dns_protocol.h"
+#include "net/http/http_request_headers.h"
 #include "net/socket/datagram_server_socket.h"
+#include "net/url_request/url_request.h"
+#include "net/url_request/url_request_context.h"
 #include "third_party/abseil-cpp/absl/types/optional.h"
 
 namespace {
 constexpr int kUdpReadBufferSize = 1024;
 constexpr int kResolutionTtl = 60;
 constexpr int kResolutionRecycleTime = 60 * 5;
+constexpr char kDnsMessageContentType[] = "application/dns-message";
+constexpr int kDohReadBufferSize = 4096;
+constexpr size_t kMaxDohResponseSize = 65535;
+constexpr size_t kMaxDohRequests = 256;
+constexpr size_t kMaxCachedResponses = 1024;
+constexpr size_t kMaxSendQueueSize = 256;
+// Not in dns_protocol.h yet. See RFC 9460.
+constexpr uint16_t kTypeSvcb = 64;
 
 std::string PackedIPv4ToString(uint32_t addr) {
   return net::IPAddress(addr >> 24, addr >> 16, addr >> 8, addr).ToString();
 }
+
+// DNS names are case-insensitive. Length octets of labels are never letters.
+std::string GetCacheKey(const net::DnsQuery& query) {
+  std::string key = base::ToLowerASCII(query.qname());
+  key.append(std::string(query.question().substr(query.qname().size())));
+  return key;
+}
+
+// Returns the largest UDP response the client of |query| accepts: the payload
+// size in its EDNS OPT record, or 512 bytes without one.
+size_t GetMaxResponseSize(const net::DnsQuery& query, size_t query_size) {
+  const char* packet = query.io_buffer()->data();
+  base::BigEndianReader reader(packet, query_size);
+  uint16_t ancount;
+  uint16_t nscount;
+  uint16_t arcount;
+  if (!reader.Skip(6) || !reader.ReadU16(&ancount) ||
+      !reader.ReadU16(&nscount) || !reader.ReadU16(&arcount)) {
+    return net::dns_protocol::kMaxUDPSize;
+  }
+  size_t num_records = ancount + nscount + arcount;
+  net::DnsRecordParser parser(
+      packet, query_size,
+      sizeof(net::dns_protocol::Header) + query.question().size(),
+      num_records);
+  for (size_t i = 0; i < num_records; ++i) {
+    net::DnsResourceRecord record;
+    if (!parser.ReadRecord(&record))
+      break;
+    // The class field of an OPT record holds the payload size.
+    if (i >= ancount + nscount && record.type == net::dns_protocol::kTypeOPT) {
+      return std::max<size_t>(record.klass, net::dns_protocol::kMaxUDPSize);
+    }
+  }
+  return net::dns_protocol::kMaxUDPSize;
+}
+
+// Drops the records of |response| and sets its TC flag if it is larger than
+// |max_size|, so that the client retries over TCP instead of getting a
+// response that its UDP stack may drop. |question_size| is the size of the
+// question section.
+std::string TruncateResponse(std::string response,
+                             size_t question_size,
+                             size_t max_size) {
+  if (response.size() <= max_size)
+    return response;
+  size_t size = sizeof(net::dns_protocol::Header) + question_size;
+  DCHECK_LE(size, response.size());
+  response.resize(size);
+  response[2] |= net::dns_protocol::kFlagTC >> 8;
+  // Zeroes ANCOUNT, NSCOUNT and ARCOUNT.
+  std::fill(response.begin() + 6, response.begin() + 12, 0);
+  return response;
+}
+
+std::string MakeEmptyResponse(const net::DnsQuery& query, uint8_t rcode) {
+  absl::optional<net::DnsQuery> query_opt;
+  query_opt.emplace(query.id(), query.qname(), query.qtype());
+  net::DnsResponse response(query.id(), /*is_authoritative=*/false,
+                            /*answers=*/{}, /*authority_records=*/{},
+                            /*additional_records=*/{}, query_opt, rcode);
+  if (!response.io_buffer())
+    return {};
+  return std::string(response.io_buffer()->data(),
+                     response.io_buffer_size());
+}
 }  // namespace
 
 namespace net {
@@ -34,14 +120,129 @@ Resolution::Resolution() = default;
 
 Resolution::~Resolution() = default;
 
-RedirectResolver::RedirectResolver(std::unique_ptr<DatagramServerSocket> socket,
-                                   const IPAddress& range,
-                                   size_t prefix)
+// Forwards one query to the DoH server and reads the response.
+class RedirectResolver::DohRequest : public URLRequest::Delegate {
+ public:
+  DohRequest(RedirectResolver* resolver,
+             const DnsQuery& query,
+             size_t query_size,
+             size_t max_response_size,
+             const IPEndPoint& address)
+      : resolver_(resolver),
+        query_(query),
+        max_response_size_(max_response_size),
+        address_(address),
+        cache_key_(GetCacheKey(query)),
+        read_buffer_(base::MakeRefCounted<IOBuffer>(kDohReadBufferSize)) {
+    // The ID is zero as recommended for caching by RFC 8484.
+    body_.assign(query.io_buffer()->data(), query_size);
+    body_[0] = 0;
+    body_[1] = 0;
+  }
+  DohRequest(const DohRequest&) = delete;
+  DohRequest& operator=(const DohRequest&) = delete;
+  ~DohRequest() override = default;
+
+  void Start(const GURL& url,
+             URLRequestContext* context,
+             const NetworkTrafficAnnotationTag& traffic_annotation) {
+    request_ = context->CreateRequest(url, HIGHEST, this, traffic_annotation);
+    request_->set_method("POST");
+    request_->SetIdempotency(IDEMPOTENT);
+    request_->set_upload(ElementsUploadDataStream::CreateWithReader(
+        base::WrapUnique(UploadOwnedBytesElementReader::CreateWithString(
+            std::move(body_))),
+        0));
+    HttpRequestHeaders headers;
+    headers.SetHeader(HttpRequestHeaders::kAccept, kDnsMessageContentType);
+    headers.SetHeader(HttpRequestHeaders::kContentType,
+                      kDnsMessageContentType);
+    request_->SetExtraRequestHeaders(headers);
+    request_->SetLoadFlags(request_->load_flags() | LOAD_DISABLE_CACHE);
+    request_->set_allow_credentials(false);
+    request_->Start();
+  }
+
+  const DnsQuery& query() const { return query_; }
+  size_t max_response_size() const { return max_response_size_; }
+  const IPEndPoint& address() const { return address_; }
+  const std::string& cache_key() const { return cache_key_; }
+  std::string& response() { return response_; }
+
+  // URLRequest::Delegate implementation.
+  void OnResponseStarted(URLRequest* request, int net_error) override {
+    if (net_error != OK) {
+      Complete(net_error);
+      return;
+    }
+    std::string mime_type;
+    if (request->GetResponseCode() != 200 ||
+        !request->response_headers()->GetMimeType(&mime_type) ||
+        mime_type != kDnsMessageContentType) {
+      Complete(ERR_DNS_MALFORMED_RESPONSE);
+      return;
+    }
+    Read();
+  }
+
+  void OnReadCompleted(URLRequest* request, int bytes_read) override {
+    if (HandleReadResult(bytes_read))
+      Read();
+  }
+
+ private:
+  void Read() {
+    for (;;) {
+      int rv = request_->Read(read_buffer_.get(), kDohReadBufferSize);
+      if (rv == ERR_IO_PENDING)
+        return;
+      if (!HandleReadResult(rv))
+        return;
+    }
+  }
+
+  // Returns false if the request is complete and |this| is deleted.
+  bool HandleReadResult(int result) {
+    if (result <= 0) {
+      Complete(result);
+      return false;
+    }
+    response_.append(read_buffer_->data(), result);
+    if (response_.size() > kMaxDohResponseSize) {
+      Complete(ERR_DNS_MALFORMED_RESPONSE);
+      return false;
+    }
+    return true;
+  }
+
+  void Complete(int result) { resolver_->OnDohComplete(this, result); }
+
+  RedirectResolver* resolver_;
+  DnsQuery query_;
+  size_t max_response_size_;
+  IPEndPoint address_;
+  std::string cache_key_;
+  std::string body_;
+  scoped_refptr<IOBuffer> read_buffer_;
+  std::string response_;
+  std::unique_ptr<URLRequest> request_;
+};
+
+RedirectResolver::RedirectResolver(
+    std::unique_ptr<DatagramServerSocket> socket,
+    const IPAddress& range,
+    size_t prefix,
+    const GURL& doh_url,
+    URLRequestContext* context,
+    const NetworkTrafficAnnotationTag& traffic_annotation)
     : socket_(std::move(socket)),
       range_(range),
       prefix_(prefix),
       offset_(0),
-      buffer_(base::MakeRefCounted<IOBufferWithSize>(kUdpReadBufferSize)) {
+      buffer_(base::MakeRefCounted<IOBufferWithSize>(kUdpReadBufferSize)),
+      doh_url_(doh_url),
+      context_(context),
+      traffic_annotation_(traffic_annotation) {
   DCHECK(socket_);
   // Start accepting connections in next run loop in case when delegate is not
   // ready to get callbacks.
@@ -60,8 +261,6 @@ void RedirectResolver::DoRead() {
     if (rv == ERR_IO_PENDING)
       return;
     rv = HandleReadResult(rv);
-    if (rv == ERR_IO_PENDING)
-      return;
     if (rv < 0) {
       LOG(INFO) << "DoRead: ignoring error " << rv;
     }
@@ -71,8 +270,6 @@ void RedirectResolver::DoRead() {
 void RedirectResolver::OnRecv(int result) {
   int rv;
   rv = HandleReadResult(result);
-  if (rv == ERR_IO_PENDING)
-    return;
   if (rv < 0) {
     LOG(INFO) << "OnRecv: ignoring error " << result;
   }
@@ -80,14 +277,6 @@ void RedirectResolver::OnRecv(int result) {
   DoRead();
 }
 
-void RedirectResolver::OnSend(int result) {
-  if (result < 0) {
-    LOG(INFO) << "OnSend: ignoring error " << result;
-  }
-
-  DoRead();
-}
-
 int RedirectResolver::HandleReadResult(int result) {
   if (result < 0)
     return result;
@@ -98,7 +287,6 @@ int RedirectResolver::HandleReadResult(int result) {
     return ERR_INVALID_ARGUMENT;
   }
 
-  int size;
   if (query.qtype() == dns_protocol::kTypeA) {
     Resolution res;
 
@@ -202,27 +390,171 @@ int RedirectResolver::HandleReadResult(int result) {
                          /*answers=*/{std::move(record)},
                          /*authority_records=*/{}, /*additional_records=*/{},
                          query_opt);
-    size = response.io_buffer_size();
-    if (size > buffer_->size() || !response.io_buffer()) {
+    if (!response.io_buffer()) {
       return ERR_NO_BUFFER_SPACE;
     }
-    std::memcpy(buffer_->data(), response.io_buffer()->data(), size);
+    Send(std::string(response.io_buffer()->data(), response.io_buffer_size()),
+         recv_address_);
+  } else if (query.qtype() == dns_protocol::kTypeAAAA ||
+             query.qtype() == dns_protocol::kTypeHttps ||
+             query.qtype() == kTypeSvcb) {
+    // Real IPv6 addresses, and the real addresses in ipv4hint and ipv6hint,
+    // would bypass the redirection. An empty answer makes clients fall back
+    // to A right away instead of retrying.
+    Send(MakeEmptyResponse(query, dns_protocol::kRcodeNOERROR), recv_address_);
+  } else if (doh_url_.is_valid()) {
+    Forward(query, result);
   } else {
-    absl::optional<DnsQuery> query_opt;
-    query_opt.emplace(query.id(), query.qname(), query.qtype());
-    DnsResponse response(query.id(), /*is_authoritative=*/false, /*answers=*/{},
-                         /*authority_records=*/{}, /*additional_records=*/{},
-                         query_opt, dns_protocol::kRcodeSERVFAIL);
-    size = response.io_buffer_size();
-    if (size > buffer_->size() || !response.io_buffer()) {
-      return ERR_NO_BUFFER_SPACE;
+    Send(MakeEmptyResponse(query, dns_protocol::kRcodeSERVFAIL),
+         recv_address_);
+  }
+
+  return OK;
+}
+
+void RedirectResolver::Forward(const DnsQuery& query, size_t size) {
+  size_t max_response_size = GetMaxResponseSize(query, size);
+  auto now = base::TimeTicks::Now();
+  auto cached = cache_.find(GetCacheKey(query));
+  if (cached != cache_.end()) {
+    if (cached->second.expiration > now) {
+      std::string response =
+          TruncateResponse(cached->second.response, query.question().size(),
+                           max_response_size);
+      response[0] = query.id() >> 8;
+      response[1] = query.id() & 0xff;
+      Send(std::move(response), recv_address_);
+      return;
+    }
+    cache_.erase(cached);
+  }
+
+  if (doh_requests_.size() >= kMaxDohRequests) {
+    Send(MakeEmptyResponse(query, dns_protocol::kRcodeSERVFAIL),
+         recv_address_);
+    return;
+  }
+
+  auto request = std::make_unique<DohRequest>(this, query, size,
+                                              max_response_size, recv_address_);
+  DohRequest* raw_request = request.get();
+  doh_requests_[raw_request] = std::move(request);
+  raw_request->Start(doh_url_, context_, traffic_annotation_);
+}
+
+void RedirectResolver::OnDohComplete(DohRequest* request, int result) {
+  auto it = doh_requests_.find(request);
+  DCHECK(it != doh_requests_.end());
+  // |request| is deleted on return. Its URLRequest may be deleted from the
+  // delegate callbacks.
+  std::unique_ptr<DohRequest> owned = std::move(it->second);
+  doh_requests_.erase(it);
+
+  const DnsQuery& query = request->query();
+  std::string& response = request->response();
+  if (result == OK) {
+    auto buffer = base::MakeRefCounted<IOBuffer>(response.size() + 1);
+    std::memcpy(buffer->data(), response.data(), response.size());
+    // Matches the ID sent to the server.
+    std::unique_ptr<DnsQuery> doh_query = query.CloneWithNewId(0);
+    DnsResponse parsed(buffer, response.size() + 1);
+    if (!parsed.InitParse(response.size(), *doh_query))
+      result = ERR_DNS_MALFORMED_RESPONSE;
+    else
+      Cache(request->cache_key(), parsed, response);
+  }
+
+  if (result != OK) {
+    LOG(INFO) << "DoH query for "
+              << DnsDomainToString(query.qname()).value_or("?")
+              << " failed: " << ErrorToShortString(result);
+    Send(MakeEmptyResponse(query, dns_protocol::kRcodeSERVFAIL),
+         request->address());
+    return;
+  }
+
+  // The full response stays cached for clients that accept it.
+  response = TruncateResponse(std::move(response), query.question().size(),
+                              request->max_response_size());
+  response[0] = query.id() >> 8;
+  response[1] = query.id() & 0xff;
+  Send(std::move(response), request->address());
+}
+
+void RedirectResolver::Cache(const std::string& key,
+                             const DnsResponse& parsed,
+                             const std::string& response) {
+  if (parsed.rcode() != dns_protocol::kRcodeNOERROR ||
+      parsed.answer_count() == 0) {
+    return;
+  }
+  uint32_t ttl = UINT32_MAX;
+  DnsRecordParser parser = parsed.Parser();
+  for (unsigned i = 0; i < parsed.answer_count(); ++i) {
+    DnsResourceRecord record;
+    if (!parser.ReadRecord(&record))
+      return;
+    ttl = std::min(ttl, record.ttl);
+  }
+  if (ttl == 0)
+    return;
+
+  auto now = base::TimeTicks::Now();
+  if (cache_.size() >= kMaxCachedResponses) {
+    for (auto it = cache_.begin(); it != cache_.end();) {
+      if (it->second.expiration <= now) {
+        it = cache_.erase(it);
+      } else {
+        ++it;
+      }
     }
-    std::memcpy(buffer_->data(), response.io_buffer()->data(), size);
+    if (cache_.size() >= kMaxCachedResponses)
+      return;
   }
+  // TTLs in cached responses are not decremented, so clients may keep them
+  // for up to twice as long.
+  CachedResponse& entry = cache_[key];
+  entry.response = response;
+  entry.expiration = now + base::TimeDelta::FromSeconds(ttl);
+}
+
+void RedirectResolver::Send(std::string response, const IPEndPoint& address) {
+  if (response.empty())
+    return;
+  if (send_queue_.size() >= kMaxSendQueueSize) {
+    LOG(INFO) << "Dropping DNS response to " << address.ToString();
+    return;
+  }
+  send_queue_.emplace_back(std::move(response), address);
+  if (send_queue_.size() == 1)
+    DoSend();
+}
 
-  return socket_->SendTo(
-      buffer_.get(), size, recv_address_,
-      base::BindOnce(&RedirectResolver::OnSend, base::Unretained(this)));
+void RedirectResolver::DoSend() {
+  while (!send_queue_.empty()) {
+    const auto& response = send_queue_.front();
+    send_buffer_ =
+        base::MakeRefCounted<IOBufferWithSize>(response.first.size());
+    std::memcpy(send_buffer_->data(), response.first.data(),
+                response.first.size());
+    int rv = socket_->SendTo(
+        send_buffer_.get(), send_buffer_->size(), response.second,
+        base::BindOnce(&RedirectResolver::OnSend, base::Unretained(this)));
+    if (rv == ERR_IO_PENDING)
+      return;
+    if (rv < 0) {
+      LOG(INFO) << "DoSend: ignoring error " << rv;
+    }
+    send_queue_.pop_front();
+  }
+}
+
+void RedirectResolver::OnSend(int result) {
+  if (result < 0) {
+    LOG(INFO) << "OnSend: ignoring error " << result;
+  }
+  send_queue_.pop_front();
+  DoSend();
 }
 
 bool RedirectResolver::IsInResolvedRange(const IPAddress& address) const {
@@ -6,10 +6,12 @@
 #define NET_TOOLS_NAIVE_REDIRECT_RESOLVER_H_
 
 #include <cstdint>
+#include <deque>
 #include <list>
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
@@ -17,11 +19,16 @@
 #include "base/time/time.h"
 #include "net/base/ip_address.h"
 #include "net/base/ip_endpoint.h"
+#include "net/traffic_annotation/network_traffic_annotation.h"
+#include "url/gurl.h"
 
 namespace net {
 
 class DatagramServerSocket;
+class DnsQuery;
+class DnsResponse;
 class IOBufferWithSize;
+class URLRequestContext;
 
 struct Resolution {
   Resolution();
@@ -34,21 +41,47 @@ struct Resolution {
   std::map<uint32_t, std::list<Resolution>::iterator>::iterator by_addr;
 };
 
+// Answers A queries with fake addresses from |range| and remembers the names
+// for redirected connections. AAAA, HTTPS and SVCB queries get empty answers,
+// because their addresses and address hints would bypass the redirection.
+// This also drops the other HTTPS and SVCB parameters, such as ALPN and ECH.
+// If |doh_url| is valid, other queries are forwarded as DNS-over-HTTPS
+// requests through |context|, i.e. through the proxy, and the responses are
+// cached until their TTLs expire. Otherwise they are answered with SERVFAIL.
+// Forwarded responses larger than the client accepts over UDP are sent
+// truncated, with the TC flag set.
 class RedirectResolver {
  public:
   RedirectResolver(std::unique_ptr<DatagramServerSocket> socket,
                    const IPAddress& range,
-                   size_t prefix);
+                   size_t prefix,
+                   const GURL& doh_url,
+                   URLRequestContext* context,
+                   const NetworkTrafficAnnotationTag& traffic_annotation);
   ~RedirectResolver();
 
   bool IsInResolvedRange(const IPAddress& address) const;
   std::string FindNameByAddress(const IPAddress& address) const;
 
  private:
+  class DohRequest;
+
+  struct CachedResponse {
+    std::string response;
+    base::TimeTicks expiration;
+  };
+
   void DoRead();
   void OnRecv(int result);
-  void OnSend(int result);
   int HandleReadResult(int result);
+  void Forward(const DnsQuery& query, size_t size);
+  void OnDohComplete(DohRequest* request, int result);
+  void Cache(const std::string& key,
+             const DnsResponse& parsed,
+             const std::string& response);
+  void Send(std::string response, const IPEndPoint& address);
+  void DoSend();
+  void OnSend(int result);
 
   std::unique_ptr<DatagramServerSocket> socket_;
   IPAddress range_;
@@ -57,6 +90,16 @@ class RedirectResolver {
   scoped_refptr<IOBufferWithSize> buffer_;
   IPEndPoint recv_address_;
 
+  const GURL doh_url_;
+  URLRequestContext* context_;
+  const NetworkTrafficAnnotationTag& traffic_annotation_;
+  std::map<DohRequest*, std::unique_ptr<DohRequest>> doh_requests_;
+  // Keyed by the question section of the query with the name lowercased.
+  std::map<std::string, CachedResponse> cache_;
+
+  std::deque<std::pair<std::string, IPEndPoint>> send_queue_;
+  scoped_refptr<IOBufferWithSize> send_buffer_;
+
   std::map<std::string, std::list<Resolution>::iterator> resolution_by_name_;
   std::map<uint32_t, std::list<Resolution>::iterator> resolution_by_addr_;
   std::list<Resolution> resolutions_;
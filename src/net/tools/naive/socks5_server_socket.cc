@@ -68,6 +68,10 @@ const HostPortPair& Socks5ServerSocket::request_endpoint() const {
   return request_endpoint_;
 }
 
+const StreamSocket* Socks5ServerSocket::transport_socket() const {
+  return transport_.get();
+}
+
 int Socks5ServerSocket::Connect(CompletionOnceCallback callback) {
   DCHECK(transport_);
   DCHECK_EQ(STATE_NONE, next_state_);
@@ -601,6 +605,8 @@ int Socks5ServerSocket::DoHandshakeReadComplete(int result) {
       request_endpoint_ = HostPortPair::FromIPEndPoint(endpoint);
     }
     buffer_.clear();
+    if (reply_ == kReplySuccess && request_endpoint_callback_)
+      std::move(request_endpoint_callback_).Run();
     next_state_ = STATE_HANDSHAKE_WRITE;
     return OK;
   }
@@ -10,7 +10,9 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
 
+#include "base/callback.h"
 #include "base/macros.h"
 #include "base/memory/scoped_refptr.h"
 #include "net/base/completion_once_callback.h"
@@ -40,6 +42,13 @@ class Socks5ServerSocket : public StreamSocket {
   ~Socks5ServerSocket() override;
 
   const HostPortPair& request_endpoint() const;
+  const StreamSocket* transport_socket() const;
+
+  // Sets a callback run during Connect() as soon as request_endpoint() is
+  // known, before the reply to the client is written.
+  void set_request_endpoint_callback(base::OnceClosure callback) {
+    request_endpoint_callback_ = std::move(callback);
+  }
 
   // StreamSocket implementation.
 
@@ -156,6 +165,7 @@ class Socks5ServerSocket : public StreamSocket {
   char reply_;
 
   HostPortPair request_endpoint_;
+  base::OnceClosure request_endpoint_callback_;
 
   NetLogWithSource net_log_;
 
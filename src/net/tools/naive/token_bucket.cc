@@ -0,0 +1,63 @@
+// Copyright 2021 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/token_bucket.h"
+
+#include <algorithm>
+
+#include "base/check_op.h"
+
+namespace net {
+
+TokenBucket::TokenBucket(int64_t rate, int64_t burst, base::TimeTicks now)
+    : rate_(rate), burst_(burst), tokens_(burst), last_refill_time_(now) {
+  DCHECK_GT(rate_, 0);
+  DCHECK_GT(burst_, 0);
+}
+
+TokenBucket::~TokenBucket() = default;
+
+bool TokenBucket::TryConsume(int64_t amount, base::TimeTicks now) {
+  Refill(now);
+  if (tokens_ < amount)
+    return false;
+  tokens_ -= amount;
+  return true;
+}
+
+void TokenBucket::Consume(int64_t amount, base::TimeTicks now) {
+  Refill(now);
+  tokens_ -= amount;
+}
+
+base::TimeDelta TokenBucket::GetDelay(base::TimeTicks now) {
+  Refill(now);
+  if (tokens_ >= 0)
+    return base::TimeDelta();
+  // Rounds up so that the debt is paid off after the delay.
+  return base::TimeDelta::FromMicroseconds(
+      (-tokens_ * base::Time::kMicrosecondsPerSecond + rate_ - 1) / rate_);
+}
+
+void TokenBucket::Refill(base::TimeTicks now) {
+  int64_t elapsed_us = (now - last_refill_time_).InMicroseconds();
+  if (elapsed_us <= 0)
+    return;
+  // Also avoids overflow below after a long idle period.
+  if (elapsed_us >=
+      (burst_ - tokens_) * base::Time::kMicrosecondsPerSecond / rate_ + 1) {
+    tokens_ = burst_;
+    last_refill_time_ = now;
+    return;
+  }
+  // Only advances the refill time by what was converted to tokens, so that
+  // frequent calls do not lose fractional tokens.
+  int64_t new_tokens = elapsed_us * rate_ / base::Time::kMicrosecondsPerSecond;
+  if (new_tokens == 0)
+    return;
+  tokens_ = std::min(burst_, tokens_ + new_tokens);
+  last_refill_time_ += base::TimeDelta::FromMicroseconds(
+      new_tokens * base::Time::kMicrosecondsPerSecond / rate_);
+}
+
+}  // namespace net
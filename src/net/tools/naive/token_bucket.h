@@ -0,0 +1,43 @@
+// Copyright 2021 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_TOKEN_BUCKET_H_
+#define NET_TOOLS_NAIVE_TOKEN_BUCKET_H_
+
+#include <cstdint>
+
+#include "base/time/time.h"
+
+namespace net {
+
+// Token bucket refilled at |rate| tokens per second up to |burst| tokens.
+// Consume() may take the bucket into debt, which callers pay back by waiting
+// GetDelay() before consuming again.
+class TokenBucket {
+ public:
+  TokenBucket(int64_t rate, int64_t burst, base::TimeTicks now);
+  TokenBucket(const TokenBucket&) = delete;
+  TokenBucket& operator=(const TokenBucket&) = delete;
+  ~TokenBucket();
+
+  // Consumes |amount| tokens if available and returns true, otherwise returns
+  // false without consuming anything.
+  bool TryConsume(int64_t amount, base::TimeTicks now);
+
+  // Consumes |amount| tokens unconditionally.
+  void Consume(int64_t amount, base::TimeTicks now);
+
+  // Returns the time until the bucket is out of debt.
+  base::TimeDelta GetDelay(base::TimeTicks now);
+
+ private:
+  void Refill(base::TimeTicks now);
+
+  const int64_t rate_;
+  const int64_t burst_;
+  int64_t tokens_;
+  base::TimeTicks last_refill_time_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_TOKEN_BUCKET_H_
@@ -0,0 +1,217 @@
+// Copyright 2021 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#include "net/tools/naive/tunnel_stream_request.h"
+
+#include <string>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/check.h"
+#include "base/memory/ptr_util.h"
+#include "base/notreached.h"
+#include "base/time/time.h"
+#include "build/build_config.h"
+#include "net/base/net_errors.h"
+#include "net/base/network_isolation_key.h"
+#include "net/base/privacy_mode.h"
+#include "net/base/proxy_server.h"
+#include "net/dns/public/secure_dns_policy.h"
+#include "net/http/http_auth.h"
+#include "net/http/http_auth_controller.h"
+#include "net/http/http_network_session.h"
+#include "net/http/http_user_agent_settings.h"
+#include "net/proxy_resolution/proxy_info.h"
+#include "net/socket/client_socket_handle.h"
+#include "net/socket/socket_tag.h"
+#include "net/socket/stream_socket.h"
+#include "net/spdy/spdy_proxy_client_socket.h"
+#include "net/spdy/spdy_session.h"
+#include "net/spdy/spdy_session_key.h"
+#include "net/spdy/spdy_session_pool.h"
+#include "url/gurl.h"
+
+namespace net {
+
+namespace {
+// Matches kHttpProxyConnectJobTunnelTimeout, which the socket pool path arms
+// while waiting for the CONNECT response on an existing session.
+#if defined(OS_ANDROID) || defined(OS_IOS)
+constexpr base::TimeDelta kTunnelTimeout = base::TimeDelta::FromSeconds(10);
+#else
+constexpr base::TimeDelta kTunnelTimeout = base::TimeDelta::FromSeconds(30);
+#endif
+}  // namespace
+
+// static
+std::unique_ptr<TunnelStreamRequest>
+TunnelStreamRequest::CreateIfSessionAvailable(
+    const HostPortPair& endpoint,
+    HttpNetworkSession* session,
+    RequestPriority priority,
+    const ProxyInfo& proxy_info,
+    const NetworkIsolationKey& network_isolation_key,
+    const NetLogWithSource& net_log,
+    const NetworkTrafficAnnotationTag& traffic_annotation) {
+  if (!proxy_info.is_https())
+    return nullptr;
+
+  // Matches the key HttpProxyConnectJob uses for raw connects.
+  SpdySessionKey key(proxy_info.proxy_server().host_port_pair(),
+                     ProxyServer::Direct(), PRIVACY_MODE_DISABLED,
+                     SpdySessionKey::IsProxySession::kTrue, SocketTag(),
+                     network_isolation_key, SecureDnsPolicy::kDisable);
+  base::WeakPtr<SpdySession> spdy_session =
+      session->spdy_session_pool()->FindAvailableSession(
+          key, /*enable_ip_based_pooling=*/false, /*is_websocket=*/false,
+          net_log);
+  if (!spdy_session)
+    return nullptr;
+
+  return base::WrapUnique(new TunnelStreamRequest(
+      endpoint, session, priority, proxy_info, network_isolation_key,
+      std::move(spdy_session), net_log, traffic_annotation));
+}
+
+TunnelStreamRequest::TunnelStreamRequest(
+    const HostPortPair& endpoint,
+    HttpNetworkSession* session,
+    RequestPriority priority,
+    const ProxyInfo& proxy_info,
+    const NetworkIsolationKey& network_isolation_key,
+    base::WeakPtr<SpdySession> spdy_session,
+    const NetLogWithSource& net_log,
+    const NetworkTrafficAnnotationTag& traffic_annotation)
+    : endpoint_(endpoint),
+      session_(session),
+      priority_(priority),
+      proxy_info_(proxy_info),
+      network_isolation_key_(network_isolation_key),
+      spdy_session_(std::move(spdy_session)),
+      net_log_(net_log),
+      traffic_annotation_(traffic_annotation),
+      next_state_(STATE_NONE),
+      socket_handle_(nullptr) {}
+
+TunnelStreamRequest::~TunnelStreamRequest() = default;
+
+int TunnelStreamRequest::Start(ClientSocketHandle* socket_handle,
+                               CompletionOnceCallback callback) {
+  DCHECK(socket_handle);
+  DCHECK_EQ(next_state_, STATE_NONE);
+  DCHECK(!callback_);
+
+  socket_handle_ = socket_handle;
+  next_state_ = STATE_CREATE_STREAM;
+  int rv = DoLoop(OK);
+  if (rv == ERR_IO_PENDING) {
+    callback_ = std::move(callback);
+    timer_.Start(FROM_HERE, kTunnelTimeout,
+                 base::BindOnce(&TunnelStreamRequest::OnTimeout,
+                                base::Unretained(this)));
+  }
+  return rv;
+}
+
+void TunnelStreamRequest::OnIOComplete(int result) {
+  DCHECK_NE(next_state_, STATE_NONE);
+  int rv = DoLoop(result);
+  if (rv != ERR_IO_PENDING) {
+    timer_.Stop();
+    std::move(callback_).Run(rv);
+  }
+}
+
+void TunnelStreamRequest::OnTimeout() {
+  DCHECK_NE(next_state_, STATE_NONE);
+  // Cancels the pending stream request or CONNECT.
+  stream_request_.reset();
+  socket_.reset();
+  next_state_ = STATE_NONE;
+  std::move(callback_).Run(ERR_TIMED_OUT);
+}
+
+int TunnelStreamRequest::DoLoop(int last_io_result) {
+  DCHECK_NE(next_state_, STATE_NONE);
+  int rv = last_io_result;
+  do {
+    State state = next_state_;
+    next_state_ = STATE_NONE;
+    switch (state) {
+      case STATE_CREATE_STREAM:
+        DCHECK_EQ(rv, OK);
+        rv = DoCreateStream();
+        break;
+      case STATE_CREATE_STREAM_COMPLETE:
+        rv = DoCreateStreamComplete(rv);
+        break;
+      case STATE_TUNNEL_CONNECT_COMPLETE:
+        rv = DoTunnelConnectComplete(rv);
+        break;
+      default:
+        NOTREACHED() << "bad state";
+        rv = ERR_UNEXPECTED;
+        break;
+    }
+  } while (rv != ERR_IO_PENDING && next_state_ != STATE_NONE);
+  return rv;
+}
+
+int TunnelStreamRequest::DoCreateStream() {
+  next_state_ = STATE_CREATE_STREAM_COMPLETE;
+  // The session may have gone away since it was found.
+  if (!spdy_session_)
+    return ERR_CONNECTION_CLOSED;
+
+  stream_request_ = std::make_unique<SpdyStreamRequest>();
+  return stream_request_->StartRequest(
+      SPDY_BIDIRECTIONAL_STREAM, spdy_session_,
+      GURL("https://" + endpoint_.ToString()),
+      /*can_send_early=*/false, priority_, SocketTag(),
+      spdy_session_->net_log(),
+      base::BindOnce(&TunnelStreamRequest::OnIOComplete,
+                     base::Unretained(this)),
+      traffic_annotation_);
+}
+
+int TunnelStreamRequest::DoCreateStreamComplete(int result) {
+  if (result < 0) {
+    stream_request_.reset();
+    return result;
+  }
+
+  next_state_ = STATE_TUNNEL_CONNECT_COMPLETE;
+  base::WeakPtr<SpdyStream> stream = stream_request_->ReleaseStream();
+  stream_request_.reset();
+  DCHECK(stream.get());
+
+  const HttpNetworkSession::Context& context = session_->context();
+  std::string user_agent;
+  if (context.http_user_agent_settings)
+    user_agent = context.http_user_agent_settings->GetUserAgent();
+  const ProxyServer& proxy_server = proxy_info_.proxy_server();
+  auto auth_controller = base::MakeRefCounted<HttpAuthController>(
+      HttpAuth::AUTH_PROXY,
+      GURL("https://" + proxy_server.host_port_pair().ToString()),
+      network_isolation_key_, session_->http_auth_cache(),
+      session_->http_auth_handler_factory(), context.host_resolver);
+  // |socket_| will set itself as |stream|'s delegate and holds a reference to
+  // the auth controller.
+  socket_ = std::make_unique<SpdyProxyClientSocket>(
+      stream, proxy_server, user_agent, endpoint_, net_log_,
+      auth_controller.get(), context.proxy_delegate);
+  return socket_->Connect(base::BindOnce(&TunnelStreamRequest::OnIOComplete,
+                                         base::Unretained(this)));
+}
+
+int TunnelStreamRequest::DoTunnelConnectComplete(int result) {
+  if (result < 0) {
+    socket_.reset();
+    return result;
+  }
+
+  socket_handle_->SetSocket(std::move(socket_));
+  return OK;
+}
+
+}  // namespace net
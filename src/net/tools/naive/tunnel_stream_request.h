@@ -0,0 +1,98 @@
+// Copyright 2021 klzgrad <kizdiv@gmail.com>. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+#ifndef NET_TOOLS_NAIVE_TUNNEL_STREAM_REQUEST_H_
+#define NET_TOOLS_NAIVE_TUNNEL_STREAM_REQUEST_H_
+
+#include <memory>
+
+#include "base/memory/weak_ptr.h"
+#include "base/timer/timer.h"
+#include "net/base/completion_once_callback.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/request_priority.h"
+#include "net/log/net_log_with_source.h"
+#include "net/traffic_annotation/network_traffic_annotation.h"
+
+namespace net {
+
+class ClientSocketHandle;
+class HttpNetworkSession;
+class NetworkIsolationKey;
+class ProxyInfo;
+class SpdySession;
+class SpdyStreamRequest;
+class StreamSocket;
+
+// Opens a tunnel as a new stream on an available HTTP/2 session to the proxy.
+// This skips the socket pool group and the connect job chain that
+// InitSocketHandleForRawConnect2() goes through even when such a session
+// already exists.
+class TunnelStreamRequest {
+ public:
+  // Returns null if |proxy_info| is not an HTTPS proxy with an available
+  // session for |network_isolation_key|. The references must outlive the
+  // request.
+  static std::unique_ptr<TunnelStreamRequest> CreateIfSessionAvailable(
+      const HostPortPair& endpoint,
+      HttpNetworkSession* session,
+      RequestPriority priority,
+      const ProxyInfo& proxy_info,
+      const NetworkIsolationKey& network_isolation_key,
+      const NetLogWithSource& net_log,
+      const NetworkTrafficAnnotationTag& traffic_annotation);
+
+  TunnelStreamRequest(const TunnelStreamRequest&) = delete;
+  TunnelStreamRequest& operator=(const TunnelStreamRequest&) = delete;
+  // Cancels the request if it is still pending.
+  ~TunnelStreamRequest();
+
+  // Like InitSocketHandleForRawConnect2(), sets the tunnel socket on
+  // |socket_handle| on success. |socket_handle| must outlive the request.
+  // Fails with ERR_TIMED_OUT if the tunnel is not established within the
+  // timeout HttpProxyConnectJob uses for tunnels.
+  int Start(ClientSocketHandle* socket_handle, CompletionOnceCallback callback);
+
+ private:
+  enum State {
+    STATE_CREATE_STREAM,
+    STATE_CREATE_STREAM_COMPLETE,
+    STATE_TUNNEL_CONNECT_COMPLETE,
+    STATE_NONE,
+  };
+
+  TunnelStreamRequest(const HostPortPair& endpoint,
+                      HttpNetworkSession* session,
+                      RequestPriority priority,
+                      const ProxyInfo& proxy_info,
+                      const NetworkIsolationKey& network_isolation_key,
+                      base::WeakPtr<SpdySession> spdy_session,
+                      const NetLogWithSource& net_log,
+                      const NetworkTrafficAnnotationTag& traffic_annotation);
+
+  void OnIOComplete(int result);
+  void OnTimeout();
+  int DoLoop(int last_io_result);
+  int DoCreateStream();
+  int DoCreateStreamComplete(int result);
+  int DoTunnelConnectComplete(int result);
+
+  const HostPortPair endpoint_;
+  HttpNetworkSession* session_;
+  RequestPriority priority_;
+  const ProxyInfo& proxy_info_;
+  const NetworkIsolationKey& network_isolation_key_;
+  base::WeakPtr<SpdySession> spdy_session_;
+  const NetLogWithSource& net_log_;
+  const NetworkTrafficAnnotationTag traffic_annotation_;
+
+  State next_state_;
+  ClientSocketHandle* socket_handle_;
+  CompletionOnceCallback callback_;
+  std::unique_ptr<SpdyStreamRequest> stream_request_;
+  std::unique_ptr<StreamSocket> socket_;
+  base::OneShotTimer timer_;
+};
+
+}  // namespace net
+#endif  // NET_TOOLS_NAIVE_TUNNEL_STREAM_REQUEST_H_